@@ -0,0 +1,393 @@
+/// @file bench_accuracy.cpp
+/// @brief Error against double precision Gabor transform versus speed
+///        for each backend and configuration
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <deque>
+#include <algorithm>
+#include <sstream>
+#include <chrono>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/imu_preprocessor.hpp"
+#include "build_type.hpp"
+
+using freq_analysis::WaveletConverter;
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ImuPreprocessor;
+using freq_analysis::DerivedChannel;
+
+namespace {
+
+struct Config {
+  float start;
+  float step;
+  size_t bands;
+  size_t buf_length;
+  float center_t;
+  float sigma;
+  size_t stride;
+};
+
+struct Signal {
+  std::string name;
+  std::vector<float> time_list;
+  std::vector<float> value_list;
+};
+
+/// @brief Backend under evaluation, converts at every stride-th sample
+/// after buffer is filled
+struct Backend {
+  std::string name;
+  std::string param;
+  // table resolution of FilterBank, 0 for direct evaluation
+  float table_resolution;
+  // threshold of energy pruning, 0 for no pruning
+  float prune_threshold;
+};
+
+struct Evaluation {
+  double max_error;
+  double rms_error;
+  double ns_per_sample_band;
+  size_t rows;
+};
+
+/// @brief Window half width of GaborFilter, 1% of peak of gaussian
+double WindowWidth(double freq, double sigma) {
+  return sigma / freq * sqrt(-2.0 * log(0.01));
+}
+
+/// @brief Reference transform of one band in double precision with exact
+/// exp and cos, over same window as GaborFilter but without value table
+double ReferenceBand(const std::deque<double>& times,
+                     const std::deque<double>& values,
+                     double center, double freq, double sigma) {
+  double width = WindowWidth(freq, sigma);
+  double sigma2 = sigma * sigma * 2.0;
+  double norm = 1.0 / sqrt(sigma2 * M_PI);
+  double re = 0.0;
+  double im = 0.0;
+  for (size_t i = 0; i < times.size(); i++) {
+    double t = times[i] - center;
+    if (fabs(t) > width) {
+      continue;
+    }
+    double tau = t * freq;
+    double gauss = norm * exp(-tau * tau / sigma2);
+    re += gauss * cos(2.0 * M_PI * tau) * values[i];
+    im += gauss * sin(2.0 * M_PI * tau) * values[i];
+  }
+  return sqrt(freq) * sqrt(re * re + im * im);
+}
+
+/// @brief Single precision transform with expf/cosf for each sample,
+/// as baseline without value table
+void DirectConvert(const std::deque<float>& times,
+                   const std::deque<float>& values, float center,
+                   const std::vector<float>& freqs, float sigma,
+                   std::vector<float>& result) {
+  result.resize(freqs.size());
+  float sigma2 = sigma * sigma * 2.0f;
+  float norm = 1.0f / sqrtf(sigma2 * static_cast<float>(M_PI));
+  for (size_t b = 0; b < freqs.size(); b++) {
+    float freq = freqs[b];
+    float width = WindowWidth(freq, sigma);
+    float re = 0.0f;
+    float im = 0.0f;
+    for (size_t i = 0; i < times.size(); i++) {
+      float t = times[i] - center;
+      if (fabsf(t) > width) {
+        continue;
+      }
+      float tau = t * freq;
+      float gauss = norm * expf(-tau * tau / sigma2);
+      re += gauss * cosf(2.0f * static_cast<float>(M_PI) * tau) * values[i];
+      im += gauss * sinf(2.0f * static_cast<float>(M_PI) * tau) * values[i];
+    }
+    result[b] = sqrtf(freq) * sqrtf(re * re + im * im);
+  }
+}
+
+/// @brief Reference rows at each conversion of signal
+void ComputeReference(const Config& config, const Signal& signal,
+                      const std::vector<float>& freqs,
+                      std::vector<std::vector<double> >& reference) {
+  reference.clear();
+  std::deque<double> times, values;
+  for (size_t i = 0; i < signal.time_list.size(); i++) {
+    if (times.size() >= config.buf_length) {
+      times.pop_front();
+      values.pop_front();
+    }
+    times.push_back(signal.time_list[i]);
+    values.push_back(signal.value_list[i]);
+    if (i + 1 < config.buf_length || (i + 1) % config.stride != 0) {
+      continue;
+    }
+    // same center as WaveletConverter, computed in float
+    double center = signal.time_list[i] - config.center_t;
+    std::vector<double> row(freqs.size());
+    for (size_t b = 0; b < freqs.size(); b++) {
+      row[b] = ReferenceBand(times, values, center, freqs[b], config.sigma);
+    }
+    reference.push_back(row);
+  }
+}
+
+/// @brief Run backend over signal and compare with reference.
+/// Relative error of each band is taken against peak of its row,
+/// since bands near zero have no meaningful relative error.
+Evaluation Evaluate(const Config& config, const Signal& signal,
+                    const Backend& backend, const std::vector<float>& freqs,
+                    const std::vector<std::vector<double> >& reference) {
+  typedef std::chrono::steady_clock Clock;
+  std::vector<std::vector<float> > results;
+  results.reserve(reference.size());
+  std::vector<float> result;
+  double seconds = 0.0;
+
+  if (backend.table_resolution > 0.0) {
+    FilterBankPtr bank(new FilterBank(config.start, config.step, config.bands,
+                                      config.sigma,
+                                      backend.table_resolution));
+    WaveletConverter conv(bank, config.buf_length, config.center_t);
+    if (backend.prune_threshold > 0.0) {
+      conv.EnablePruning(backend.prune_threshold, 10);
+    }
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < signal.time_list.size(); i++) {
+      conv.AddValue(signal.time_list[i], signal.value_list[i]);
+      if (i + 1 < config.buf_length || (i + 1) % config.stride != 0) {
+        continue;
+      }
+      conv.Convert(result);
+      results.push_back(result);
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  } else {
+    std::deque<float> times, values;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < signal.time_list.size(); i++) {
+      if (times.size() >= config.buf_length) {
+        times.pop_front();
+        values.pop_front();
+      }
+      times.push_back(signal.time_list[i]);
+      values.push_back(signal.value_list[i]);
+      if (i + 1 < config.buf_length || (i + 1) % config.stride != 0) {
+        continue;
+      }
+      DirectConvert(times, values, signal.time_list[i] - config.center_t,
+                    freqs, config.sigma, result);
+      results.push_back(result);
+    }
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  Evaluation eval;
+  eval.max_error = 0.0;
+  eval.rms_error = 0.0;
+  eval.rows = results.size();
+  size_t count = 0;
+  for (size_t r = 0; r < results.size() && r < reference.size(); r++) {
+    double peak = 0.0;
+    for (size_t b = 0; b < reference[r].size(); b++) {
+      peak = std::max(peak, reference[r][b]);
+    }
+    if (peak <= 0.0) {
+      continue;
+    }
+    for (size_t b = 0; b < reference[r].size(); b++) {
+      double error = fabs(results[r][b] - reference[r][b]) / peak;
+      eval.max_error = std::max(eval.max_error, error);
+      eval.rms_error += error * error;
+      count++;
+    }
+  }
+  eval.rms_error = count ? sqrt(eval.rms_error / count) : 0.0;
+  eval.ns_per_sample_band = results.empty() ? 0.0 :
+      seconds * 1e9 / (results.size() * config.buf_length * config.bands);
+  return eval;
+}
+
+void MakeTone(const std::string& name, float rate, float seconds,
+              float freq1, float freq2, Signal& signal) {
+  signal.name = name;
+  size_t length = static_cast<size_t>(rate * seconds);
+  for (size_t i = 0; i < length; i++) {
+    float t = i / rate;
+    signal.time_list.push_back(t);
+    signal.value_list.push_back(sin(2.0 * M_PI * freq1 * t) +
+                                (freq2 > 0.0 ?
+                                 0.5 * sin(2.0 * M_PI * freq2 * t) : 0.0));
+  }
+}
+
+/// @brief Linear chirp from freq1 to freq2 over whole signal
+void MakeChirp(float rate, float seconds, float freq1, float freq2,
+               Signal& signal) {
+  signal.name = "chirp";
+  size_t length = static_cast<size_t>(rate * seconds);
+  double k = (freq2 - freq1) / seconds;
+  for (size_t i = 0; i < length; i++) {
+    double t = i / rate;
+    signal.time_list.push_back(t);
+    signal.value_list.push_back(
+        sin(2.0 * M_PI * (freq1 * t + 0.5 * k * t * t)));
+  }
+}
+
+/// @brief Magnitude of acc of example data, irregular sampling as recorded
+bool ReadImu(const std::string& filename, float seconds, Signal& signal) {
+  ImuColumns data;
+  ImuDataReader reader;
+  if (!reader.Read(filename, data) || data.size() == 0) {
+    return false;
+  }
+  std::vector<DerivedChannel> channels(1, freq_analysis::kAccNorm);
+  ImuPreprocessor preprocessor(channels);
+  std::vector<std::vector<float> > derived;
+  preprocessor.Process(data, 0, data.size(), derived);
+  size_t pos = filename.find_last_of('/');
+  signal.name = pos == std::string::npos ? filename :
+      filename.substr(pos + 1);
+  for (size_t i = 0; i < data.size() && data.time[i] <= seconds; i++) {
+    signal.time_list.push_back(data.time[i]);
+    signal.value_list.push_back(derived[0][i]);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // same filters as sample_walking
+  Config config;
+  config.start = 0.25;
+  config.step = sqrt(2.0);
+  config.bands = 10;
+  config.buf_length = 1024;
+  config.center_t = 8.0;
+  config.sigma = 1.0;
+  config.stride = 4;
+  float seconds = 60.0;
+  float rate = 100.0;
+  std::string imu_file("example/right_leg.dat");
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    if (option == "--seconds" && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (option == "--sigma" && i + 1 < argc) {
+      config.sigma = atof(argv[++i]);
+    } else if (option == "--bands" && i + 1 < argc) {
+      config.bands = atoi(argv[++i]);
+    } else if (option == "--buffer" && i + 1 < argc) {
+      config.buf_length = atoi(argv[++i]);
+    } else if (option == "--stride" && i + 1 < argc) {
+      config.stride = atoi(argv[++i]);
+    } else if (option == "--data" && i + 1 < argc) {
+      imu_file = argv[++i];
+    } else {
+      std::cerr << "usage: bench_accuracy [--seconds s] [--sigma s]"
+                << " [--bands N] [--buffer N] [--stride N] [--data file]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (config.stride == 0 || config.bands == 0 || config.buf_length == 0) {
+    std::cerr << "stride, bands and buffer must be positive" << std::endl;
+    return 1;
+  }
+
+  std::vector<Signal> signals(3);
+  MakeTone("tone", rate, seconds, 2.0, 0.0, signals[0]);
+  MakeTone("two_tones", rate, seconds, 1.0, 3.5, signals[1]);
+  MakeChirp(rate, seconds, 0.3, 6.0, signals[2]);
+  Signal imu;
+  if (ReadImu(imu_file, seconds, imu)) {
+    signals.push_back(imu);
+  } else {
+    std::cerr << "skip imu data: " << imu_file << std::endl;
+  }
+
+  std::vector<Backend> backends;
+  Backend direct = {"direct_float", "-", 0.0, 0.0};
+  backends.push_back(direct);
+  float resolutions[] = {2.0, 4.0, 8.0, 16.0, 32.0, 64.0};
+  for (size_t i = 0; i < 6; i++) {
+    std::ostringstream oss;
+    oss << "resolution=" << resolutions[i];
+    Backend table = {"table", oss.str(), resolutions[i], 0.0};
+    backends.push_back(table);
+  }
+  float thresholds[] = {0.01, 0.1, 1.0};
+  for (size_t i = 0; i < 3; i++) {
+    std::ostringstream oss;
+    oss << "resolution=8,threshold=" << thresholds[i];
+    Backend pruning = {"pruning", oss.str(), 8.0, thresholds[i]};
+    backends.push_back(pruning);
+  }
+
+  // direct evaluation is compiled here with -O2, other backends run in
+  // libraries, so its time is comparable only with optimised libraries
+  bool compare_direct =
+      freq_analysis::CheckLibrariesOptimized("bench_accuracy");
+
+  FilterBank bank(config.start, config.step, config.bands, config.sigma);
+  const std::vector<float>& freqs = bank.Frequencies();
+  std::cout << "# errors relative to peak of each row, "
+            << "'*' marks Pareto-optimal settings of each signal" << std::endl;
+  if (!compare_direct) {
+    std::cout << "# libraries are not optimised, direct_float is excluded"
+              << " from Pareto comparison" << std::endl;
+  }
+  std::cout << "# signal backend param rows max_error rms_error"
+            << " ns/sample/band pareto" << std::endl;
+  for (size_t s = 0; s < signals.size(); s++) {
+    std::vector<std::vector<double> > reference;
+    ComputeReference(config, signals[s], freqs, reference);
+    std::vector<Evaluation> evals;
+    for (size_t b = 0; b < backends.size(); b++) {
+      evals.push_back(Evaluate(config, signals[s], backends[b], freqs,
+                               reference));
+    }
+    for (size_t b = 0; b < backends.size(); b++) {
+      bool excluded = !compare_direct && backends[b].table_resolution == 0.0;
+      // dominated if other setting is not worse in both and better in one
+      bool dominated = false;
+      for (size_t o = 0; o < backends.size(); o++) {
+        if (!compare_direct && backends[o].table_resolution == 0.0) {
+          continue;
+        }
+        if (o != b &&
+            evals[o].max_error <= evals[b].max_error &&
+            evals[o].ns_per_sample_band <= evals[b].ns_per_sample_band &&
+            (evals[o].max_error < evals[b].max_error ||
+             evals[o].ns_per_sample_band < evals[b].ns_per_sample_band)) {
+          dominated = true;
+        }
+      }
+      std::cout << signals[s].name << " " << backends[b].name << " "
+                << backends[b].param << " " << evals[b].rows << " "
+                << evals[b].max_error << " " << evals[b].rms_error << " "
+                << evals[b].ns_per_sample_band << " "
+                << (excluded ? "n/a" : (dominated ? "-" : "*")) << std::endl;
+    }
+  }
+  return 0;
+}
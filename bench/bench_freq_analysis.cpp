@@ -0,0 +1,382 @@
+/// @file bench_freq_analysis.cpp
+/// @brief Micro-benchmarks of GaborFilter and WaveletConverter hot paths,
+///        results are written in JSON
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <list>
+#include <algorithm>
+#include <chrono>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "freq_analysis/gabor_wavelet.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/trace.hpp"
+#include "build_type.hpp"
+
+using freq_analysis::GaborFilter;
+using freq_analysis::WaveletConverter;
+using freq_analysis::Tracer;
+using freq_analysis::TraceScope;
+
+namespace {
+
+const float kTimeStep = 0.01;  // 100 Hz
+
+struct Options {
+  bool quick;
+  size_t repetitions;
+  double min_time;
+  std::string filter;
+  std::string output;
+};
+
+/// @brief Statistics of repetitions in ns per sample per band
+struct Measurement {
+  double median;
+  double min;
+  double max;
+  size_t iterations;
+};
+
+/// @brief Parameters of one benchmark point, written as JSON members
+struct Point {
+  std::string name;
+  size_t buffer_length;
+  size_t bands;
+  float freq_min;
+  float freq_max;
+  float sigma;
+};
+
+// results are accumulated here, so that calls are not optimized out
+volatile float g_sink = 0.0;
+
+/// @brief Run func repeatedly. Calls for at least min_time before timing
+/// as warm-up, which also decides number of calls of each repetition.
+/// @param func Function to measure
+/// @param work Samples x bands processed by one call
+template <class Func>
+Measurement Measure(Func func, double work, const Options& options) {
+  typedef std::chrono::steady_clock Clock;
+  size_t iterations = 0;
+  Clock::time_point start = Clock::now();
+  do {
+    func();
+    iterations++;
+  } while (std::chrono::duration<double>(Clock::now() - start).count()
+           < options.min_time);
+
+  std::vector<double> ns_list;
+  for (size_t r = 0; r < options.repetitions; r++) {
+    start = Clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      func();
+    }
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    ns_list.push_back(seconds * 1e9 / (iterations * work));
+  }
+  std::sort(ns_list.begin(), ns_list.end());
+  Measurement m;
+  m.median = ns_list[ns_list.size() / 2];
+  m.min = ns_list.front();
+  m.max = ns_list.back();
+  m.iterations = iterations;
+  return m;
+}
+
+/// @brief Input of length samples, sum of two sine waves with noise
+void MakeSignal(size_t length, std::list<float>& time_list,
+                std::list<float>& value_list) {
+  time_list.clear();
+  value_list.clear();
+  for (size_t i = 0; i < length; i++) {
+    float t = i * kTimeStep;
+    time_list.push_back(t);
+    value_list.push_back(sin(2.0 * M_PI * 1.7 * t) +
+                         0.5 * sin(2.0 * M_PI * 5.3 * t) +
+                         0.1 * (static_cast<float>(rand()) / RAND_MAX));
+  }
+}
+
+class JsonWriter {
+ public:
+  explicit JsonWriter(const Options& options) : first_(true) {
+    out_ << "{\n  \"benchmark\": \"bench_freq_analysis\",\n"
+         << "  \"unit\": \"ns/sample/band\",\n"
+         << "  \"repetitions\": " << options.repetitions << ",\n"
+         << "  \"min_time\": " << options.min_time << ",\n"
+         << "  \"optimized_libraries\": "
+         << (freq_analysis::LibrariesOptimized() ? "true" : "false") << ",\n"
+         << "  \"results\": [";
+  }
+
+  void Add(const Point& p, const Measurement& m) {
+    out_ << (first_ ? "\n" : ",\n")
+         << "    {\"name\": \"" << p.name << "\""
+         << ", \"buffer_length\": " << p.buffer_length
+         << ", \"bands\": " << p.bands
+         << ", \"freq_min\": " << p.freq_min
+         << ", \"freq_max\": " << p.freq_max
+         << ", \"sigma\": " << p.sigma
+         << ", \"iterations\": " << m.iterations
+         << ", \"median\": " << m.median
+         << ", \"min\": " << m.min
+         << ", \"max\": " << m.max << "}";
+    first_ = false;
+  }
+
+  std::string Finish() {
+    out_ << "\n  ]\n}\n";
+    return out_.str();
+  }
+
+ private:
+  std::ostringstream out_;
+  bool first_;
+};
+
+bool Selected(const Options& options, const std::string& name) {
+  return options.filter.empty() ||
+      name.find(options.filter) != std::string::npos;
+}
+
+void Report(JsonWriter& json, const Point& p, const Measurement& m) {
+  std::cerr << p.name << " buf=" << p.buffer_length << " bands=" << p.bands
+            << " freq=" << p.freq_min << "-" << p.freq_max
+            << " sigma=" << p.sigma << ": " << m.median << " ns"
+            << std::endl;
+  json.Add(p, m);
+}
+
+/// @brief GaborFilter::Filter over whole buffer, single band
+void BenchFilter(const Options& options,
+                 const std::vector<size_t>& buffers,
+                 const std::vector<float>& freqs,
+                 const std::vector<float>& sigmas, JsonWriter& json) {
+  if (!Selected(options, "gabor_filter")) {
+    return;
+  }
+  for (size_t b = 0; b < buffers.size(); b++) {
+    std::list<float> time_list, value_list;
+    MakeSignal(buffers[b], time_list, value_list);
+    float center = buffers[b] * kTimeStep * 0.5;
+    for (size_t s = 0; s < sigmas.size(); s++) {
+      for (size_t f = 0; f < freqs.size(); f++) {
+        // table step as FilterBank with resolution 8
+        GaborFilter gabor(freqs[f], sigmas[s], 1.0 / (freqs[f] * 8.0));
+        Measurement m = Measure([&]() {
+            g_sink = g_sink + gabor.Filter(time_list, value_list, center);
+          }, buffers[b], options);
+        Point p = {"gabor_filter", buffers[b], 1, freqs[f], freqs[f],
+                   sigmas[s]};
+        Report(json, p, m);
+      }
+    }
+  }
+}
+
+/// @brief GaborFilter::ApproxValue at times spread over window
+void BenchApproxValue(const Options& options,
+                      const std::vector<float>& freqs,
+                      const std::vector<float>& sigmas, JsonWriter& json) {
+  if (!Selected(options, "approx_value")) {
+    return;
+  }
+  const size_t kCalls = 4096;
+  for (size_t s = 0; s < sigmas.size(); s++) {
+    for (size_t f = 0; f < freqs.size(); f++) {
+      GaborFilter gabor(freqs[f], sigmas[s], 1.0 / (freqs[f] * 8.0));
+      float width = sigmas[s] * 3.0 / freqs[f];
+      std::vector<float> times(kCalls);
+      for (size_t i = 0; i < kCalls; i++) {
+        times[i] = width * (2.0 * i / kCalls - 1.0);
+      }
+      Measurement m = Measure([&]() {
+          float sum = 0.0;
+          for (size_t i = 0; i < kCalls; i++) {
+            sum += gabor.ApproxValue(times[i]).first;
+          }
+          g_sink = g_sink + sum;
+        }, kCalls, options);
+      Point p = {"approx_value", 0, 1, freqs[f], freqs[f], sigmas[s]};
+      Report(json, p, m);
+    }
+  }
+}
+
+/// @brief WaveletConverter::Convert with full buffer
+void BenchConvert(const Options& options,
+                  const std::vector<size_t>& buffers,
+                  const std::vector<size_t>& bands,
+                  const std::vector<std::pair<float, float> >& ranges,
+                  const std::vector<float>& sigmas, JsonWriter& json) {
+  if (!Selected(options, "convert")) {
+    return;
+  }
+  for (size_t b = 0; b < buffers.size(); b++) {
+    std::list<float> time_list, value_list;
+    MakeSignal(buffers[b], time_list, value_list);
+    float center = buffers[b] * kTimeStep * 0.5;
+    for (size_t n = 0; n < bands.size(); n++) {
+      for (size_t r = 0; r < ranges.size(); r++) {
+        for (size_t s = 0; s < sigmas.size(); s++) {
+          float start = ranges[r].first;
+          float step = bands[n] > 1 ?
+              pow(ranges[r].second / start, 1.0 / (bands[n] - 1)) : 1.0;
+          WaveletConverter conv(start, step, bands[n], buffers[b], center,
+                                sigmas[s]);
+          std::list<float>::const_iterator t = time_list.begin();
+          std::list<float>::const_iterator v = value_list.begin();
+          for (; t != time_list.end(); t++, v++) {
+            conv.AddValue(*t, *v);
+          }
+          std::vector<float> result;
+          Measurement m = Measure([&]() {
+              conv.Convert(result);
+              g_sink = g_sink + result[0];
+            }, static_cast<double>(buffers[b]) * bands[n], options);
+          Point p = {"convert", buffers[b], bands[n], ranges[r].first,
+                     ranges[r].second, sigmas[s]};
+          Report(json, p, m);
+        }
+      }
+    }
+  }
+}
+
+/// @brief WaveletConverter::AddValue with full buffer, per sample
+void BenchAddValue(const Options& options,
+                   const std::vector<size_t>& buffers, JsonWriter& json) {
+  if (!Selected(options, "add_value")) {
+    return;
+  }
+  const size_t kCalls = 1024;
+  for (size_t b = 0; b < buffers.size(); b++) {
+    WaveletConverter conv(1.0, 2.0, 1, buffers[b], 1.0);
+    float time = 0.0;
+    for (size_t i = 0; i < buffers[b]; i++) {
+      conv.AddValue(time, 1.0);
+      time += kTimeStep;
+    }
+    Measurement m = Measure([&]() {
+        for (size_t i = 0; i < kCalls; i++) {
+          conv.AddValue(time, 1.0);
+          time += kTimeStep;
+        }
+      }, kCalls, options);
+    Point p = {"add_value", buffers[b], 1, 1.0, 1.0, 2.0};
+    Report(json, p, m);
+  }
+}
+
+/// @brief Cost of one TraceScope with tracing disabled and enabled
+void BenchTrace(const Options& options, JsonWriter& json) {
+  if (!Selected(options, "trace_scope")) {
+    return;
+  }
+  const size_t kCalls = 4096;
+  for (int enabled = 0; enabled < 2; enabled++) {
+    Tracer::Enable(enabled != 0);
+    Measurement m = Measure([&]() {
+        // events beyond buffer are dropped, so buffer does not grow
+        for (size_t i = 0; i < kCalls; i++) {
+          TraceScope trace("bench");
+        }
+      }, kCalls, options);
+    Tracer::Enable(false);
+    Tracer::Clear();
+    Point p = {enabled ? "trace_scope_on" : "trace_scope_off",
+               0, 1, 0.0, 0.0, 0.0};
+    Report(json, p, m);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.quick = false;
+  options.repetitions = 5;
+  options.min_time = 0.05;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    if (option == "--quick") {
+      options.quick = true;
+    } else if (option == "--reps" && i + 1 < argc) {
+      options.repetitions = atoi(argv[++i]);
+    } else if (option == "--min-time" && i + 1 < argc) {
+      options.min_time = atof(argv[++i]);
+    } else if (option == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (option == "--out" && i + 1 < argc) {
+      options.output = argv[++i];
+    } else {
+      std::cerr << "usage: bench_freq_analysis [--quick] [--reps N]"
+                << " [--min-time seconds] [--filter name] [--out file.json]"
+                << std::endl;
+      return 1;
+    }
+  }
+  if (options.repetitions == 0) {
+    options.repetitions = 1;
+  }
+  freq_analysis::CheckLibrariesOptimized("bench_freq_analysis");
+  srand(1);
+
+  std::vector<size_t> buffers;
+  std::vector<size_t> bands;
+  std::vector<float> freqs;
+  std::vector<float> sigmas;
+  std::vector<std::pair<float, float> > ranges;
+  if (options.quick) {
+    size_t b[] = {64, 1024, 16384};
+    size_t n[] = {1, 50, 500};
+    float f[] = {2.0};
+    float s[] = {2.0};
+    buffers.assign(b, b + 3);
+    bands.assign(n, n + 3);
+    freqs.assign(f, f + 1);
+    sigmas.assign(s, s + 1);
+    ranges.push_back(std::make_pair(0.25f, 8.0f));
+  } else {
+    size_t b[] = {64, 256, 1024, 4096, 16384, 65536};
+    size_t n[] = {1, 10, 50, 100, 500};
+    float f[] = {0.5, 2.0, 8.0};
+    float s[] = {1.0, 2.0, 4.0};
+    buffers.assign(b, b + 6);
+    bands.assign(n, n + 5);
+    freqs.assign(f, f + 3);
+    sigmas.assign(s, s + 3);
+    ranges.push_back(std::make_pair(0.25f, 8.0f));
+    ranges.push_back(std::make_pair(1.0f, 40.0f));
+  }
+
+  JsonWriter json(options);
+  BenchFilter(options, buffers, freqs, sigmas, json);
+  BenchApproxValue(options, freqs, sigmas, json);
+  BenchAddValue(options, buffers, json);
+  BenchTrace(options, json);
+  std::vector<float> convert_sigmas(1, 2.0);
+  BenchConvert(options, buffers, bands, ranges,
+               options.quick ? convert_sigmas : sigmas, json);
+
+  std::string result = json.Finish();
+  if (options.output.empty()) {
+    std::cout << result;
+  } else {
+    std::ofstream out(options.output.c_str());
+    out << result;
+  }
+  return 0;
+}
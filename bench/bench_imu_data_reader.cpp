@@ -0,0 +1,125 @@
+/// @file bench_imu_data_reader.cpp
+/// @brief Parse throughput of ImuDataReader against line-by-line reader
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include "freq_analysis/imu_data_reader.hpp"
+
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+
+/// @brief Reader used by sample_walking before ImuDataReader
+size_t ReadLegacy(const std::string& filename) {
+  std::ifstream datafile(filename.c_str());
+  std::vector<float> time_list;
+  std::vector<std::vector<float> > acc_list;
+  std::vector<std::vector<float> > gyro_list;
+  std::string str;
+  while (getline(datafile, str)) {
+    std::vector<std::string> split_str;
+    boost::split(split_str, str, boost::is_any_of(" "));
+    if (split_str.size() != 7) {
+      continue;
+    }
+    if (split_str[0].at(0) == '#') {
+      continue;
+    }
+    time_list.push_back(boost::lexical_cast<float>(split_str[0]));
+    std::vector<float> acc;
+    for (size_t i = 1; i < 4; i++) {
+      acc.push_back(boost::lexical_cast<float>(split_str[i]));
+    }
+    acc_list.push_back(acc);
+    std::vector<float> gyro;
+    for (size_t i = 4; i < 7; i++) {
+      gyro.push_back(boost::lexical_cast<float>(split_str[i]));
+    }
+    gyro_list.push_back(gyro);
+  }
+  return time_list.size();
+}
+
+/// @brief Write input file repeated with shifted time stamps
+bool Replicate(const std::string& src, const std::string& dst,
+               size_t repeat) {
+  ImuColumns data;
+  ImuDataReader reader(1);
+  if (!reader.Read(src, data) || data.size() == 0) {
+    return false;
+  }
+  FILE* fp = fopen(dst.c_str(), "w");
+  if (!fp) {
+    return false;
+  }
+  float span = data.time.back() - data.time.front() + 0.01;
+  for (size_t r = 0; r < repeat; r++) {
+    for (size_t i = 0; i < data.size(); i++) {
+      fprintf(fp, "%f %f %f %f %f %f %f\n", data.time[i] + span * r,
+              data.acc_x[i], data.acc_y[i], data.acc_z[i],
+              data.gyro_x[i], data.gyro_y[i], data.gyro_z[i]);
+    }
+  }
+  fclose(fp);
+  return true;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: bench_imu_data_reader <data file> [repeat]"
+              << std::endl;
+    return 1;
+  }
+  size_t repeat = argc >= 3 ? atoi(argv[2]) : 20;
+  std::string filename("bench_imu_data_reader.dat");
+  if (!Replicate(argv[1], filename, repeat)) {
+    std::cerr << "cannot prepare data from " << argv[1] << std::endl;
+    return 1;
+  }
+
+  ImuColumns data;
+  ImuDataReader probe(1);
+  probe.Read(filename, data);
+  double mbytes = probe.BytesRead() / 1e6;
+  std::cout << "# reader threads rows MB/s (" << mbytes << " MB)"
+            << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  size_t rows = ReadLegacy(filename);
+  std::cout << "legacy 1 " << rows << " " << mbytes / Seconds(start)
+            << std::endl;
+
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads == 0) {
+    max_threads = 1;
+  }
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    ImuDataReader reader(threads);
+    start = std::chrono::steady_clock::now();
+    reader.Read(filename, data);
+    std::cout << "mmap " << threads << " " << data.size() << " "
+              << mbytes / Seconds(start) << std::endl;
+  }
+  remove(filename.c_str());
+  return 0;
+}
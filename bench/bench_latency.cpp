@@ -0,0 +1,204 @@
+/// @file bench_latency.cpp
+/// @brief Latency distribution of AddValue and Convert cycles
+///        at fixed sensor rate
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "latency_histogram.hpp"
+#include "build_type.hpp"
+
+using freq_analysis::WaveletConverter;
+using freq_analysis::LatencyHistogram;
+
+namespace {
+
+const int64_t kNanoPerSec = 1000000000;
+
+int64_t MonotonicNow() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * kNanoPerSec + ts.tv_nsec;
+}
+
+void SleepUntil(int64_t deadline) {
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(deadline / kNanoPerSec);
+  ts.tv_nsec = static_cast<long>(deadline % kNanoPerSec);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+         == EINTR) {
+  }
+}
+
+struct Options {
+  float rate;
+  size_t cycles;
+  bool pace;
+  int cpu;
+  int priority;
+};
+
+/// @brief Simulated sensor value, walking-like fundamental with harmonic
+float Signal(float t) {
+  return 9.8 + 2.0 * sin(2.0 * M_PI * 1.8 * t) +
+      0.7 * sin(2.0 * M_PI * 3.6 * t) +
+      0.2 * (static_cast<float>(rand()) / RAND_MAX - 0.5);
+}
+
+/// @brief Run cycles of AddValue and Convert, recording latency of each
+/// @param missed Number of cycles which did not finish within period
+void RunConfig(const Options& options, size_t bands, size_t buf_length,
+               LatencyHistogram& histogram, uint64_t& missed) {
+  float dt = 1.0 / options.rate;
+  float step = bands > 1 ? pow(8.0 / 0.25, 1.0 / (bands - 1)) : 1.0;
+  WaveletConverter conv(0.25, step, bands, buf_length,
+                        buf_length * dt * 0.5);
+  // fill buffer before recording, steady state is measured
+  float time = 0.0;
+  for (size_t i = 0; i < buf_length; i++) {
+    conv.AddValue(time, Signal(time));
+    time += dt;
+  }
+
+  histogram.Reset();
+  missed = 0;
+  std::vector<float> result;
+  int64_t period = static_cast<int64_t>(kNanoPerSec / options.rate);
+  int64_t deadline = MonotonicNow();
+  for (size_t i = 0; i < options.cycles; i++) {
+    if (options.pace) {
+      deadline += period;
+      SleepUntil(deadline);
+    }
+    float value = Signal(time);
+    int64_t start = MonotonicNow();
+    conv.AddValue(time, value);
+    conv.Convert(result);
+    int64_t latency = MonotonicNow() - start;
+    histogram.Record(static_cast<uint64_t>(latency));
+    if (latency > period) {
+      missed++;
+    }
+    time += dt;
+  }
+}
+
+/// @brief Pin calling thread to cpu
+/// @return Description of pinning for report
+std::string PinCpu(int cpu) {
+  if (cpu < 0) {
+    return "none";
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    return "failed";
+  }
+  return "cpu " + std::to_string(cpu);
+}
+
+/// @brief Set SCHED_FIFO priority of calling thread
+/// @return Description of policy for report
+std::string SetPriority(int priority) {
+  if (priority <= 0) {
+    return "SCHED_OTHER";
+  }
+  struct sched_param param;
+  param.sched_priority = priority;
+  if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+    return "SCHED_OTHER (SCHED_FIFO not permitted)";
+  }
+  return "SCHED_FIFO " + std::to_string(priority);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.rate = 100.0;
+  options.cycles = 2000;
+  options.pace = true;
+  options.cpu = -1;
+  options.priority = 0;
+  std::vector<size_t> bands_list;
+  std::vector<size_t> buf_list;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    if (option == "--rate" && i + 1 < argc) {
+      options.rate = atof(argv[++i]);
+    } else if (option == "--cycles" && i + 1 < argc) {
+      options.cycles = atoi(argv[++i]);
+    } else if (option == "--no-pace") {
+      options.pace = false;
+    } else if (option == "--cpu" && i + 1 < argc) {
+      options.cpu = atoi(argv[++i]);
+    } else if (option == "--priority" && i + 1 < argc) {
+      options.priority = atoi(argv[++i]);
+    } else if (option == "--bands" && i + 1 < argc) {
+      bands_list.push_back(atoi(argv[++i]));
+    } else if (option == "--buffer" && i + 1 < argc) {
+      buf_list.push_back(atoi(argv[++i]));
+    } else {
+      std::cerr << "usage: bench_latency [--rate Hz] [--cycles N]"
+                << " [--no-pace] [--cpu N] [--priority N]"
+                << " [--bands N]... [--buffer N]..." << std::endl;
+      return 1;
+    }
+  }
+  if (options.rate <= 0.0 || options.cycles == 0) {
+    std::cerr << "rate and cycles must be positive" << std::endl;
+    return 1;
+  }
+  if (bands_list.empty()) {
+    size_t b[] = {10, 50, 200};
+    bands_list.assign(b, b + 3);
+  }
+  if (buf_list.empty()) {
+    size_t b[] = {256, 1024, 4096};
+    buf_list.assign(b, b + 3);
+  }
+  freq_analysis::CheckLibrariesOptimized("bench_latency");
+  srand(1);
+
+  std::string pinning = PinCpu(options.cpu);
+  std::string policy = SetPriority(options.priority);
+  std::cout << "# rate " << options.rate << " Hz, "
+            << options.cycles << " cycles, "
+            << (options.pace ? "paced" : "back to back") << std::endl;
+  std::cout << "# pinning " << pinning << ", running on cpu "
+            << sched_getcpu() << " of " << sysconf(_SC_NPROCESSORS_ONLN)
+            << ", policy " << policy << std::endl;
+  std::cout << "# bands buffer mean[us] p50[us] p99[us] p99.9[us] max[us]"
+            << " missed" << std::endl;
+
+  LatencyHistogram histogram;
+  for (size_t n = 0; n < bands_list.size(); n++) {
+    for (size_t b = 0; b < buf_list.size(); b++) {
+      uint64_t missed = 0;
+      RunConfig(options, bands_list[n], buf_list[b], histogram, missed);
+      std::cout << bands_list[n] << " " << buf_list[b] << " "
+                << histogram.Mean() * 1e-3 << " "
+                << histogram.Percentile(50.0) * 1e-3 << " "
+                << histogram.Percentile(99.0) * 1e-3 << " "
+                << histogram.Percentile(99.9) * 1e-3 << " "
+                << histogram.Max() * 1e-3 << " "
+                << missed << std::endl;
+    }
+  }
+  return 0;
+}
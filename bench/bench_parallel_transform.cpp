@@ -0,0 +1,96 @@
+/// @file bench_parallel_transform.cpp
+/// @brief Speedup of ParallelTransform over number of threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "freq_analysis/parallel_transform.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/spectrogram.hpp"
+
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ParallelTransform;
+using freq_analysis::Spectrogram;
+
+bool Identical(const Spectrogram& a, const Spectrogram& b) {
+  if (a.Rows() != b.Rows() || a.Times() != b.Times()) {
+    return false;
+  }
+  for (size_t r = 0; r < a.Rows(); r++) {
+    for (size_t i = 0; i < a.Bands(); i++) {
+      if (a.At(r, i) != b.At(r, i)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: bench_parallel_transform <data file> [repeat]"
+              << " [max threads]" << std::endl;
+    return 1;
+  }
+  size_t repeat = argc >= 3 ? atoi(argv[2]) : 1;
+  size_t max_threads = argc >= 4 ? atoi(argv[3]) :
+      std::thread::hardware_concurrency();
+  if (max_threads == 0) {
+    max_threads = 1;
+  }
+
+  ImuColumns data;
+  ImuDataReader reader;
+  if (!reader.Read(argv[1], data) || data.size() == 0) {
+    std::cerr << "invalid or missing data file: " << argv[1] << std::endl;
+    return 1;
+  }
+  std::vector<float> times;
+  std::vector<float> values;
+  float span = data.time.back() - data.time.front() + 0.01;
+  for (size_t r = 0; r < repeat; r++) {
+    for (size_t i = 0; i < data.size(); i++) {
+      times.push_back(data.time[i] + span * r);
+      values.push_back(sqrt(data.acc_x[i] * data.acc_x[i]
+                            + data.acc_y[i] * data.acc_y[i]
+                            + data.acc_z[i] * data.acc_z[i]));
+    }
+  }
+
+  // same setting as sample_walking
+  FilterBankPtr bank(new FilterBank(0.25, sqrt(2.0), 10, 1.0));
+  ParallelTransform transform(bank, 1024, 8.0);
+  Spectrogram reference(bank->Frequencies());
+  double base = 0.0;
+  std::cout << "# threads seconds speedup identical (" << times.size()
+            << " samples)" << std::endl;
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    Spectrogram results(bank->Frequencies());
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    transform.Run(times, values, 0, threads, results);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    if (threads == 1) {
+      base = seconds;
+      reference = results;
+      std::cout << threads << " " << seconds << " 1 1" << std::endl;
+    } else {
+      std::cout << threads << " " << seconds << " " << base / seconds << " "
+                << Identical(results, reference) << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+/// @file bench_result_writer.cpp
+/// @brief Write time and size of result formats
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "freq_analysis/result_writer_factory.hpp"
+
+using freq_analysis::ResultWriterPtr;
+using freq_analysis::CreateResultWriter;
+
+/// @brief Writer used by sample_walking before ResultWriter,
+///        rows of result file and time-frequency-value plot file
+void WriteLegacy(const std::string& filename,
+                 const std::vector<float>& freqs,
+                 const std::vector<float>& times,
+                 const std::vector<std::vector<float> >& results) {
+  std::ofstream resultfile(filename.c_str());
+  for (size_t i = 0; i < freqs.size(); i++) {
+    for (size_t j = 0; j < times.size(); j++) {
+      resultfile << times[j] << " " << freqs[i] << " "
+                 << results[j][i] << std::endl;
+    }
+    resultfile << std::endl;
+  }
+}
+
+double FileSize(const std::string& filename) {
+  struct stat st;
+  return stat(filename.c_str(), &st) == 0 ? st.st_size / 1e6 : 0.0;
+}
+
+int main(int argc, char** argv) {
+  size_t rows = argc >= 2 ? atoi(argv[1]) : 100000;
+  size_t bands = argc >= 3 ? atoi(argv[2]) : 50;
+
+  std::vector<float> freqs;
+  for (size_t i = 0; i < bands; i++) {
+    freqs.push_back(0.25 * (i + 1));
+  }
+  std::vector<float> times(rows);
+  std::vector<std::vector<float> > results(rows, std::vector<float>(bands));
+  srand(1);
+  for (size_t j = 0; j < rows; j++) {
+    times[j] = j * 0.01;
+    for (size_t i = 0; i < bands; i++) {
+      results[j][i] = static_cast<float>(rand()) / RAND_MAX * 100.0;
+    }
+  }
+
+  std::cout << "# format seconds MB (" << rows << " rows, " << bands
+            << " bands)" << std::endl;
+  std::string filename("bench_result_writer.out");
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  WriteLegacy(filename, freqs, times, results);
+  std::cout << "legacy_gnuplot3d "
+            << std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count()
+            << " " << FileSize(filename) << std::endl;
+
+  const char* formats[] = {"text", "npy", "gnuplot"};
+  for (size_t f = 0; f < 3; f++) {
+    ResultWriterPtr writer = CreateResultWriter(formats[f]);
+    start = std::chrono::steady_clock::now();
+    writer->Open(filename, freqs);
+    for (size_t j = 0; j < rows; j++) {
+      writer->Write(times[j], results[j]);
+    }
+    writer->Close();
+    std::cout << formats[f] << " "
+              << std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start).count()
+              << " " << FileSize(filename) << std::endl;
+  }
+  remove(filename.c_str());
+  return 0;
+}
@@ -0,0 +1,376 @@
+/// @file bench_scaling.cpp
+/// @brief Capacity of one machine for independent sensor streams,
+///        running many WaveletConverters at fixed rate on worker threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/signal_generator.hpp"
+#include "latency_histogram.hpp"
+#include "build_type.hpp"
+
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::WaveletConverter;
+using freq_analysis::WaveletConverterPtr;
+using freq_analysis::ConverterStats;
+using freq_analysis::SignalGenerator;
+using freq_analysis::LatencyHistogram;
+
+namespace {
+
+const int64_t kNanoPerSec = 1000000000;
+
+int64_t ClockNow(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * kNanoPerSec + ts.tv_nsec;
+}
+
+void SleepUntil(int64_t deadline) {
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(deadline / kNanoPerSec);
+  ts.tv_nsec = static_cast<long>(deadline % kNanoPerSec);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+         == EINTR) {
+  }
+}
+
+struct Options {
+  float rate;
+  size_t convert_every;  ///< ticks between Convert of each stream
+  size_t bands;
+  size_t buf_length;
+  size_t ticks;
+  float max_overrun;     ///< config is stopped after this times its length
+  bool private_bank;
+  bool pin;
+};
+
+/// @brief Streams sharing one simulated sensor waveform at different phases
+struct StreamSet {
+  std::vector<WaveletConverterPtr> conv_list;
+  std::vector<size_t> offset_list;
+  std::vector<float> wave;
+  uint64_t tick_base;  ///< ticks run by previous configs
+};
+
+/// @brief Result of one worker
+struct WorkerResult {
+  uint64_t ticks;
+  uint64_t missed;
+  LatencyHistogram work;  ///< work time of each tick[ns]
+};
+
+/// @brief Ingest one sample into each stream of [begin, end),
+///        converting streams whose turn it is
+void Tick(StreamSet& streams, const Options& options, uint64_t tick,
+          size_t begin, size_t end, std::vector<float>& result) {
+  float time = tick / options.rate;
+  for (size_t s = begin; s < end; s++) {
+    const std::vector<float>& wave = streams.wave;
+    float value = wave[(tick + streams.offset_list[s]) % wave.size()];
+    streams.conv_list[s]->AddValue(time, value);
+    // staggered, so each tick converts same share of streams
+    if ((tick + s) % options.convert_every == 0) {
+      streams.conv_list[s]->Convert(result);
+    }
+  }
+}
+
+/// @brief Run ticks for streams of [begin, end) from start time.
+///        Tick i must finish by start + (i + 1) * period.
+void Worker(StreamSet& streams, const Options& options, size_t begin,
+            size_t end, int cpu, const std::atomic<int64_t>& start,
+            WorkerResult& worker) {
+  if (options.pin && cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+  std::vector<float> result;
+  int64_t t0;
+  while ((t0 = start.load(std::memory_order_acquire)) == 0) {
+    std::this_thread::yield();
+  }
+  int64_t period = static_cast<int64_t>(kNanoPerSec / options.rate);
+  int64_t limit = t0 + static_cast<int64_t>(
+      options.ticks * period * options.max_overrun);
+  worker.ticks = 0;
+  worker.missed = 0;
+  worker.work.Reset();
+  for (size_t i = 0; i < options.ticks; i++) {
+    SleepUntil(t0 + i * period);
+    int64_t begin_ns = ClockNow(CLOCK_MONOTONIC);
+    Tick(streams, options, streams.tick_base + i, begin, end, result);
+    int64_t end_ns = ClockNow(CLOCK_MONOTONIC);
+    worker.work.Record(end_ns - begin_ns);
+    worker.ticks++;
+    if (end_ns > t0 + static_cast<int64_t>(i + 1) * period) {
+      worker.missed++;
+    }
+    if (end_ns > limit) {
+      // overloaded, remaining ticks would all be late
+      worker.missed += options.ticks - i - 1;
+      break;
+    }
+  }
+}
+
+/// @brief Create streams and fill their buffers
+void CreateStreams(StreamSet& streams, const Options& options,
+                   size_t count) {
+  float step = options.bands > 1 ?
+      pow(8.0 / 0.25, 1.0 / (options.bands - 1)) : 1.0;
+  float center = options.buf_length / options.rate * 0.5;
+  FilterBankPtr bank(new FilterBank(0.25, step, options.bands));
+  streams.conv_list.clear();
+  streams.offset_list.clear();
+  for (size_t s = 0; s < count; s++) {
+    if (options.private_bank && s > 0) {
+      bank = FilterBankPtr(new FilterBank(0.25, step, options.bands));
+    }
+    streams.conv_list.push_back(WaveletConverterPtr(
+        new WaveletConverter(bank, options.buf_length, center)));
+    streams.offset_list.push_back(s * 7919);
+  }
+  std::vector<float> result;
+  for (size_t i = 0; i < options.buf_length; i++) {
+    for (size_t s = 0; s < count; s++) {
+      const std::vector<float>& wave = streams.wave;
+      float value = wave[(i + streams.offset_list[s]) % wave.size()];
+      streams.conv_list[s]->AddValue(i / options.rate, value);
+    }
+  }
+  streams.tick_base = options.buf_length;
+}
+
+/// @brief Bytes touched by streams per tick: buffers and state of
+///        converters, and value tables of distinct filter banks
+size_t WorkingSet(const StreamSet& streams) {
+  size_t bytes = 0;
+  ConverterStats stats;
+  FilterBankPtr last;
+  for (size_t s = 0; s < streams.conv_list.size(); s++) {
+    streams.conv_list[s]->Stats(stats);
+    bytes += stats.memory_bytes;
+    if (streams.conv_list[s]->Bank() != last) {
+      bytes += stats.bank_memory_bytes;
+      last = streams.conv_list[s]->Bank();
+    }
+  }
+  return bytes;
+}
+
+/// @brief Smallest cache holding bytes
+std::string CacheLevel(size_t bytes, long l2, long l3) {
+  if (l2 > 0 && bytes <= static_cast<size_t>(l2)) {
+    return "L2";
+  } else if (l3 > 0 && bytes <= static_cast<size_t>(l3)) {
+    return "L3";
+  } else if (l2 <= 0 && l3 <= 0) {
+    return "?";
+  }
+  return "DRAM";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.rate = 100.0;
+  float convert_rate = 10.0;
+  options.bands = 10;
+  options.buf_length = 256;
+  options.ticks = 200;
+  options.max_overrun = 3.0;
+  options.private_bank = false;
+  options.pin = false;
+  std::vector<size_t> stream_list;
+  std::vector<size_t> thread_list;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    if (option == "--rate" && i + 1 < argc) {
+      options.rate = atof(argv[++i]);
+    } else if (option == "--convert-rate" && i + 1 < argc) {
+      convert_rate = atof(argv[++i]);
+    } else if (option == "--bands" && i + 1 < argc) {
+      options.bands = atoi(argv[++i]);
+    } else if (option == "--buffer" && i + 1 < argc) {
+      options.buf_length = atoi(argv[++i]);
+    } else if (option == "--ticks" && i + 1 < argc) {
+      options.ticks = atoi(argv[++i]);
+    } else if (option == "--max-overrun" && i + 1 < argc) {
+      options.max_overrun = atof(argv[++i]);
+    } else if (option == "--streams" && i + 1 < argc) {
+      stream_list.push_back(atoi(argv[++i]));
+    } else if (option == "--threads" && i + 1 < argc) {
+      thread_list.push_back(atoi(argv[++i]));
+    } else if (option == "--private-bank") {
+      options.private_bank = true;
+    } else if (option == "--pin") {
+      options.pin = true;
+    } else {
+      std::cerr << "usage: bench_scaling [--rate Hz] [--convert-rate Hz]"
+                << " [--bands N] [--buffer N] [--ticks N]"
+                << " [--max-overrun X] [--streams N]... [--threads N]..."
+                << " [--private-bank] [--pin]" << std::endl;
+      return 1;
+    }
+  }
+  if (options.rate <= 0.0 || convert_rate <= 0.0 || options.ticks == 0 ||
+      options.bands == 0 || options.buf_length == 0) {
+    std::cerr << "rate, bands, buffer and ticks must be positive"
+              << std::endl;
+    return 1;
+  }
+  options.convert_every = std::max(
+      static_cast<size_t>(options.rate / convert_rate + 0.5),
+      static_cast<size_t>(1));
+  size_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+  if (stream_list.empty()) {
+    size_t s[] = {1, 10, 100, 1000, 10000};
+    stream_list.assign(s, s + 5);
+  }
+  if (thread_list.empty()) {
+    for (size_t t = 1; t < cpus; t *= 2) {
+      thread_list.push_back(t);
+    }
+    thread_list.push_back(cpus);
+  }
+  freq_analysis::CheckLibrariesOptimized("bench_scaling");
+  long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+  StreamSet streams;
+  {
+    // walking-like waveform of 10 s shared by streams
+    SignalGenerator generator(1, options.rate, 1);
+    generator.SetOffset(0, 9.8);
+    generator.AddGait(0, 5.0, 1.8);
+    generator.AddTone(0, 0.8, 0.9);
+    generator.AddNoise(0, 0.1);
+    double time;
+    streams.wave.resize(static_cast<size_t>(options.rate * 10.0) + 1);
+    for (size_t i = 0; i < streams.wave.size(); i++) {
+      generator.Next(time, &streams.wave[i]);
+    }
+  }
+
+  std::cout << "# rate " << options.rate << " Hz, Convert "
+            << options.rate / options.convert_every << " Hz per stream, "
+            << options.bands << " bands, buffer " << options.buf_length
+            << ", " << options.ticks << " ticks, "
+            << (options.private_bank ? "private" : "shared")
+            << " filter banks" << std::endl;
+  std::cout << "# " << cpus << " cpus, L2 " << l2 / 1024 << " KiB, L3 "
+            << l3 / 1024 << " KiB, "
+            << (options.pin ? "workers pinned" : "workers not pinned")
+            << std::endl;
+  std::cout << "# streams threads working_set[KiB] fits cpu[%]"
+            << " cores_busy streams/core p99_tick[%] max_tick[%] missed[%]"
+            << std::endl;
+
+  // per thread count, largest stream count meeting all deadlines and
+  // smallest one missing them
+  std::vector<size_t> met(thread_list.size(), 0);
+  std::vector<size_t> first_missed(thread_list.size(), 0);
+  std::vector<size_t> sorted(stream_list);
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t n = 0; n < sorted.size(); n++) {
+    size_t count = sorted[n];
+    if (count == 0) {
+      continue;
+    }
+    CreateStreams(streams, options, count);
+    size_t working_set = WorkingSet(streams);
+    for (size_t t = 0; t < thread_list.size(); t++) {
+      size_t threads = std::min(std::max(thread_list[t],
+                                         static_cast<size_t>(1)), count);
+      std::vector<WorkerResult> results(threads);
+      std::vector<std::thread> workers;
+      std::atomic<int64_t> start(0);
+      for (size_t w = 0; w < threads; w++) {
+        size_t begin = count * w / threads;
+        size_t end = count * (w + 1) / threads;
+        workers.push_back(std::thread(
+            Worker, std::ref(streams), std::cref(options), begin, end,
+            static_cast<int>(w % cpus), std::cref(start),
+            std::ref(results[w])));
+      }
+      int64_t cpu_start = ClockNow(CLOCK_PROCESS_CPUTIME_ID);
+      int64_t wall_start = ClockNow(CLOCK_MONOTONIC);
+      // first tick after workers are started
+      start.store(wall_start + 10000000, std::memory_order_release);
+      for (size_t w = 0; w < threads; w++) {
+        workers[w].join();
+      }
+      double wall = (ClockNow(CLOCK_MONOTONIC) - wall_start) * 1e-9;
+      double cpu = (ClockNow(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) * 1e-9;
+
+      LatencyHistogram work;
+      uint64_t ticks = 0;
+      uint64_t missed = 0;
+      // samples ingested, counting only ticks which were run
+      double stream_ticks = 0.0;
+      for (size_t w = 0; w < threads; w++) {
+        work.Merge(results[w].work);
+        ticks += results[w].ticks;
+        missed += results[w].missed;
+        stream_ticks += static_cast<double>(results[w].ticks) *
+            (count * (w + 1) / threads - count * w / threads);
+      }
+      streams.tick_base += options.ticks;
+      double period = 1e9 / options.rate;
+      double cores_busy = wall > 0.0 ? cpu / wall : 0.0;
+      double missed_ratio =
+          static_cast<double>(missed) / (options.ticks * threads);
+      std::cout << count << " " << threads << " "
+                << working_set / 1024 << " "
+                << CacheLevel(working_set, l2, l3) << " "
+                << cores_busy / cpus * 100.0 << " "
+                << cores_busy << " "
+                << (cpu > 0.0 ? stream_ticks / options.rate / cpu : 0.0)
+                << " "
+                << work.Percentile(99.0) / period * 100.0 << " "
+                << work.Max() / period * 100.0 << " "
+                << missed_ratio * 100.0
+                << (ticks < options.ticks * threads ? " (stopped)" : "")
+                << std::endl;
+      if (missed == 0) {
+        met[t] = std::max(met[t], count);
+      } else if (first_missed[t] == 0) {
+        first_missed[t] = count;
+      }
+    }
+  }
+
+  for (size_t t = 0; t < thread_list.size(); t++) {
+    std::cout << "# threads " << thread_list[t] << ": deadlines met up to "
+              << met[t] << " streams";
+    if (first_missed[t] > 0) {
+      std::cout << ", first missed at " << first_missed[t] << " streams";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+/// @file bench_spectrum_publisher.cpp
+/// @brief Writer cost of SpectrumPublisher under reader contention
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <stdlib.h>
+
+#include "freq_analysis/spectrum_publisher.hpp"
+
+using freq_analysis::Spectrum;
+using freq_analysis::SpectrumPublisher;
+
+/// @brief Measure ns per Publish() with given number of busy readers
+double MeasurePublish(size_t bands, size_t readers, size_t count) {
+  std::vector<float> freqs(bands, 1.0);
+  SpectrumPublisher publisher(freqs);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (size_t r = 0; r < readers; r++) {
+    threads.push_back(std::thread([&]() {
+          Spectrum spectrum;
+          while (!done.load(std::memory_order_relaxed)) {
+            publisher.Read(spectrum);
+          }
+        }));
+  }
+
+  std::vector<float> values(bands, 0.5);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; i++) {
+    publisher.Publish(static_cast<float>(i), values);
+  }
+  std::chrono::steady_clock::time_point end =
+      std::chrono::steady_clock::now();
+
+  done = true;
+  for (size_t r = 0; r < threads.size(); r++) {
+    threads[r].join();
+  }
+  return std::chrono::duration<double, std::nano>(end - start).count()
+      / static_cast<double>(count);
+}
+
+int main(int argc, char** argv) {
+  size_t bands = 50;
+  size_t max_readers = 8;
+  size_t count = 1000000;
+  if (argc >= 2) {
+    bands = atoi(argv[1]);
+  }
+  if (argc >= 3) {
+    max_readers = atoi(argv[2]);
+  }
+
+  std::cout << "# readers ns_per_publish (bands: " << bands << ")"
+            << std::endl;
+  for (size_t readers = 0; readers <= max_readers;
+       readers = (readers == 0 ? 1 : readers * 2)) {
+    std::cout << readers << " " << MeasurePublish(bands, readers, count)
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,308 @@
+/// @file bench_walking.cpp
+/// @brief End-to-end throughput of sample_walking workload on example data,
+///        compared with baseline file
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/imu_preprocessor.hpp"
+#include "freq_analysis/spectrogram.hpp"
+#include "freq_analysis/result_writer_factory.hpp"
+#include "build_type.hpp"
+
+using freq_analysis::WaveletConverter;
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ImuPreprocessor;
+using freq_analysis::DerivedChannel;
+using freq_analysis::Spectrogram;
+using freq_analysis::ResultWriterPtr;
+
+namespace {
+
+const char* kPhases[] = {"parse", "magnitude", "convert", "write", "total"};
+const size_t kPhaseCount = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string BaseName(const std::string& path) {
+  size_t pos = path.find_last_of('/');
+  return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+/// @brief Concatenate data repeat times, shifting time of each copy
+/// so that time keeps increasing
+bool Replicate(const std::string& filename, size_t repeat,
+               const std::string& outname, size_t& samples) {
+  ImuColumns data;
+  ImuDataReader reader;
+  if (!reader.Read(filename, data) || data.size() < 2) {
+    return false;
+  }
+  FILE* fp = fopen(outname.c_str(), "w");
+  if (!fp) {
+    return false;
+  }
+  float period = data.time.back() - data.time.front() +
+      (data.time.back() - data.time.front()) / (data.size() - 1);
+  fprintf(fp, "# time acc.x acc.y acc.z gyro.x gyro.y gyro.z\n");
+  for (size_t k = 0; k < repeat; k++) {
+    for (size_t i = 0; i < data.size(); i++) {
+      fprintf(fp, "%f %f %f %f %f %f %f\n", data.time[i] + k * period,
+              data.acc_x[i], data.acc_y[i], data.acc_z[i],
+              data.gyro_x[i], data.gyro_y[i], data.gyro_z[i]);
+    }
+  }
+  fclose(fp);
+  samples = data.size() * repeat;
+  return true;
+}
+
+/// @brief Same processing as SampleDataReader::Proc and WriteResult
+/// @param seconds Time of each phase, last one is total
+void RunWorkload(const std::string& filename, const std::string& outname,
+                 std::vector<double>& seconds) {
+  seconds.assign(kPhaseCount, 0.0);
+  Clock::time_point total = Clock::now();
+
+  Clock::time_point start = Clock::now();
+  ImuColumns data;
+  ImuDataReader reader;
+  reader.Read(filename, data);
+  seconds[0] = Seconds(start);
+
+  start = Clock::now();
+  std::vector<DerivedChannel> channels(1, freq_analysis::kAccNorm);
+  ImuPreprocessor preprocessor(channels);
+  std::vector<std::vector<float> > derived;
+  preprocessor.Process(data, 0, data.size(), derived);
+  seconds[1] = Seconds(start);
+
+  start = Clock::now();
+  float time_offset = 8.0;
+  WaveletConverter conv(0.25, sqrt(2.0), 10, 1024, time_offset, 1.0);
+  std::vector<float> freqs;
+  conv.Frequencies(freqs);
+  Spectrogram spectrogram(freqs, freq_analysis::kColumnMajor);
+  float start_proc = time_offset * 2.0;
+  std::vector<float> result;
+  for (size_t i = 0; i < data.size(); i++) {
+    float time = data.time[i];
+    conv.AddValue(time, derived[0][i]);
+    if (time > start_proc) {
+      conv.Convert(result);
+      spectrogram.Append(time - time_offset, result);
+    }
+  }
+  seconds[2] = Seconds(start);
+
+  start = Clock::now();
+  ResultWriterPtr writer = freq_analysis::CreateResultWriter("text");
+  writer->WriteAll(outname, spectrogram);
+  seconds[3] = Seconds(start);
+
+  seconds[4] = Seconds(total);
+}
+
+/// @brief Read baseline of "dataset phase ns_per_sample" lines,
+/// "repeat N" line since ratio of warm-up samples depends on length,
+/// and "optimized 0|1" line since unoptimised libraries are not comparable
+/// @param optimized -1 if baseline has no optimized line
+bool ReadBaseline(const std::string& filename, size_t& repeat,
+                  int& optimized, std::map<std::string, double>& baseline) {
+  std::ifstream file(filename.c_str());
+  if (!file) {
+    return false;
+  }
+  optimized = -1;
+  std::string line;
+  while (getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream iss(line);
+    std::string dataset, phase;
+    double ns;
+    if (line.compare(0, 7, "repeat ") == 0) {
+      repeat = atoi(line.c_str() + 7);
+    } else if (line.compare(0, 10, "optimized ") == 0) {
+      optimized = atoi(line.c_str() + 10);
+    } else if (iss >> dataset >> phase >> ns) {
+      baseline[dataset + " " + phase] = ns;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // 0 takes --repeat of baseline
+  size_t repeat = 0;
+  size_t reps = 3;
+  double threshold = 10.0;
+  // shorter phases are too noisy to be judged
+  double min_seconds = 0.01;
+  bool update = false;
+  std::string baseline_file("bench/walking_baseline.txt");
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    if (option == "--repeat" && i + 1 < argc) {
+      repeat = atoi(argv[++i]);
+    } else if (option == "--reps" && i + 1 < argc) {
+      reps = atoi(argv[++i]);
+    } else if (option == "--threshold" && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else if (option == "--min-seconds" && i + 1 < argc) {
+      min_seconds = atof(argv[++i]);
+    } else if (option == "--baseline" && i + 1 < argc) {
+      baseline_file = argv[++i];
+    } else if (option == "--update-baseline") {
+      update = true;
+    } else if (option.compare(0, 2, "--") == 0) {
+      std::cerr << "usage: bench_walking [--repeat N] [--reps N]"
+                << " [--threshold percent] [--min-seconds s]"
+                << " [--baseline file]"
+                << " [--update-baseline] [data files...]" << std::endl;
+      return 1;
+    } else {
+      files.push_back(option);
+    }
+  }
+  if (files.empty()) {
+    files.push_back("example/right_leg.dat");
+    files.push_back("example/left_leg.dat");
+    files.push_back("example/body.dat");
+  }
+  if (reps == 0) {
+    reps = 1;
+  }
+  bool optimized = freq_analysis::CheckLibrariesOptimized("bench_walking");
+
+  std::map<std::string, double> baseline;
+  if (!update) {
+    size_t baseline_repeat = 1;
+    int baseline_optimized = -1;
+    if (!ReadBaseline(baseline_file, baseline_repeat, baseline_optimized,
+                      baseline)) {
+      std::cerr << "no baseline " << baseline_file
+                << ", run with --update-baseline to create" << std::endl;
+      return 1;
+    }
+    if (baseline_optimized != (optimized ? 1 : 0)) {
+      std::cerr << "baseline was taken with "
+                << (baseline_optimized == 1 ? "optimised" :
+                    baseline_optimized == 0 ? "unoptimised" : "unknown")
+                << " libraries, this build is "
+                << (optimized ? "optimised" : "unoptimised")
+                << ", run with --update-baseline to compare" << std::endl;
+      return 1;
+    }
+    if (repeat == 0) {
+      repeat = baseline_repeat;
+    } else if (baseline_repeat != repeat) {
+      std::cerr << "baseline was taken with --repeat " << baseline_repeat
+                << std::endl;
+      return 1;
+    }
+  }
+  if (repeat == 0) {
+    repeat = 1;
+  }
+
+  std::string dataname("bench_walking_input.dat");
+  std::string outname("bench_walking_result.dat");
+  // ns per sample of each "dataset phase", best of repetitions
+  std::map<std::string, double> current;
+  std::map<std::string, double> current_seconds;
+  std::vector<std::string> keys;
+
+  std::cout << "# dataset samples samples/s";
+  for (size_t p = 0; p < kPhaseCount; p++) {
+    std::cout << " " << kPhases[p] << "[s]";
+  }
+  std::cout << std::endl;
+  for (size_t f = 0; f < files.size(); f++) {
+    size_t samples = 0;
+    if (!Replicate(files[f], repeat, dataname, samples)) {
+      std::cerr << "cannot read " << files[f] << std::endl;
+      return 1;
+    }
+    std::vector<double> best(kPhaseCount, 0.0);
+    for (size_t r = 0; r < reps; r++) {
+      std::vector<double> seconds;
+      RunWorkload(dataname, outname, seconds);
+      for (size_t p = 0; p < kPhaseCount; p++) {
+        if (r == 0 || seconds[p] < best[p]) {
+          best[p] = seconds[p];
+        }
+      }
+    }
+    std::string dataset = BaseName(files[f]);
+    std::cout << dataset << " " << samples << " " << samples / best[4];
+    for (size_t p = 0; p < kPhaseCount; p++) {
+      std::cout << " " << best[p];
+      std::string key = dataset + " " + kPhases[p];
+      current[key] = best[p] * 1e9 / samples;
+      current_seconds[key] = best[p];
+      keys.push_back(key);
+    }
+    std::cout << std::endl;
+  }
+  unlink(dataname.c_str());
+  unlink(outname.c_str());
+
+  if (update) {
+    std::ofstream file(baseline_file.c_str());
+    file << "# dataset phase ns_per_sample\n";
+    file << "repeat " << repeat << "\n";
+    file << "optimized " << (optimized ? 1 : 0) << "\n";
+    for (size_t i = 0; i < keys.size(); i++) {
+      file << keys[i] << " " << current[keys[i]] << "\n";
+    }
+    std::cout << "baseline written to " << baseline_file << std::endl;
+    return file ? 0 : 1;
+  }
+
+  bool regressed = false;
+  std::cout << "# dataset phase ns/sample baseline change[%]" << std::endl;
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::map<std::string, double>::const_iterator it =
+        baseline.find(keys[i]);
+    if (it == baseline.end() || it->second <= 0.0) {
+      continue;
+    }
+    double change = (current[keys[i]] / it->second - 1.0) * 100.0;
+    bool slow = change > threshold &&
+        current_seconds[keys[i]] >= min_seconds;
+    std::cout << keys[i] << " " << current[keys[i]] << " " << it->second
+              << " " << change << (slow ? " REGRESSION" : "") << std::endl;
+    regressed = regressed || slow;
+  }
+  if (regressed) {
+    std::cout << "slowdown exceeds " << threshold << "%" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+/// @file build_type.hpp
+/// @brief Whether benchmarked libraries are built with optimisation
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_BUILD_TYPE_HPP_
+#define FREQ_ANALYSIS_BUILD_TYPE_HPP_
+
+#include <iostream>
+
+namespace freq_analysis {
+
+/// @brief Benchmarks are always compiled with -O2, but the libraries they
+/// time only with CMAKE_BUILD_TYPE Release or RelWithDebInfo, which defines
+/// FREQ_ANALYSIS_OPTIMIZED for all targets.
+inline bool LibrariesOptimized() {
+#ifdef FREQ_ANALYSIS_OPTIMIZED
+  return true;
+#else
+  return false;
+#endif
+}
+
+/// @brief Warn that times are of unoptimised libraries
+/// @return LibrariesOptimized()
+/// @param name Name of benchmark
+inline bool CheckLibrariesOptimized(const char* name) {
+  if (!LibrariesOptimized()) {
+    std::cerr << name << ": libraries are built without optimisation,"
+              << " configure with cmake -DCMAKE_BUILD_TYPE=RelWithDebInfo"
+              << std::endl;
+  }
+  return LibrariesOptimized();
+}
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_BUILD_TYPE_HPP_
@@ -0,0 +1,126 @@
+/// @file latency_histogram.hpp
+/// @brief Log-linear histogram of latencies for benchmarks
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_LATENCY_HISTOGRAM_HPP_
+#define FREQ_ANALYSIS_LATENCY_HISTOGRAM_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+namespace freq_analysis {
+
+/// @brief Histogram in the manner of HdrHistogram. Values below
+/// 2^kSubBits are counted exactly, larger values in buckets whose width
+/// doubles with each power of two, so relative error is below
+/// 2^-kSubBits (0.8%) over whole range with fixed memory and
+/// constant cost of Record.
+class LatencyHistogram {
+ public:
+  static const int kSubBits = 7;
+  static const uint64_t kSubCount = 1ull << kSubBits;
+
+  LatencyHistogram() : count_list_((64 - kSubBits + 1) * kSubCount, 0) {
+    Reset();
+  }
+
+  void Reset() {
+    std::fill(count_list_.begin(), count_list_.end(), 0);
+    count_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+    sum_ = 0.0;
+  }
+
+  void Record(uint64_t value) {
+    count_list_[Index_(value)]++;
+    count_++;
+    if (value < min_) {
+      min_ = value;
+    }
+    if (value > max_) {
+      max_ = value;
+    }
+    sum_ += value;
+  }
+
+  /// @brief Add counts of other histogram, e.g. of other thread
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < count_list_.size(); i++) {
+      count_list_[i] += other.count_list_[i];
+    }
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+  }
+
+  /// @brief Upper bound of bucket holding the percentile, max is exact
+  /// @param percentile Percentile in [0, 100]
+  uint64_t Percentile(double percentile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    }
+    if (rank >= count_) {
+      return max_;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < count_list_.size(); i++) {
+      seen += count_list_[i];
+      if (seen >= rank) {
+        uint64_t upper = UpperBound_(i);
+        return upper < max_ ? upper : max_;
+      }
+    }
+    return max_;
+  }
+
+  uint64_t Count() const {
+    return count_;
+  }
+  uint64_t Min() const {
+    return count_ ? min_ : 0;
+  }
+  uint64_t Max() const {
+    return max_;
+  }
+  double Mean() const {
+    return count_ ? sum_ / count_ : 0.0;
+  }
+
+ private:
+  std::vector<uint64_t> count_list_;
+  uint64_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  double sum_;
+
+  static size_t Index_(uint64_t value) {
+    if (value < kSubCount) {
+      return static_cast<size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - kSubBits;
+    uint64_t sub = value >> shift;  // in [kSubCount, 2 * kSubCount)
+    return static_cast<size_t>((shift + 1) * kSubCount + (sub - kSubCount));
+  }
+
+  static uint64_t UpperBound_(size_t index) {
+    if (index < kSubCount) {
+      return index;
+    }
+    int shift = static_cast<int>(index / kSubCount) - 1;
+    uint64_t sub = index % kSubCount + kSubCount;
+    return ((sub + 1) << shift) - 1;
+  }
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_LATENCY_HISTOGRAM_HPP_
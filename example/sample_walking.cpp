@@ -9,71 +9,106 @@
 #include <vector>
 #include <string>
 
+#include <stdlib.h>
 #include <math.h>
 
 #include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
 
 #include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/columnar_log.hpp"
+#include "freq_analysis/result_writer_factory.hpp"
+#include "freq_analysis/pipeline.hpp"
+#include "freq_analysis/parallel_transform.hpp"
+#include "freq_analysis/imu_preprocessor.hpp"
+#include "freq_analysis/spectrogram.hpp"
+#include "freq_analysis/trace.hpp"
+#include "freq_analysis/call_recorder.hpp"
 
 using freq_analysis::WaveletConverter;
 using freq_analysis::WaveletConverterPtr;
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ColumnarLogReader;
+using freq_analysis::ResultWriterPtr;
+using freq_analysis::ConversionPipeline;
+using freq_analysis::PipelineSample;
+using freq_analysis::StageStats;
+using freq_analysis::ParallelTransform;
+using freq_analysis::ImuPreprocessor;
+using freq_analysis::DerivedChannel;
+using freq_analysis::Spectrogram;
+using freq_analysis::SpectrogramPtr;
+using freq_analysis::SpectrogramView;
+using freq_analysis::Tracer;
+using freq_analysis::TraceScope;
+using freq_analysis::CallRecorder;
+using freq_analysis::CallRecorderPtr;
 
 class SampleDataReader {
  public:
   SampleDataReader() {
     time_offset_ = 8.0;
+    buf_length_ = 1024;
     conv_ = WaveletConverterPtr(
-        new WaveletConverter(0.25, sqrt(2.0), 10, 1024, time_offset_, 1.0));
+        new WaveletConverter(0.25, sqrt(2.0), 10, buf_length_, time_offset_,
+                             1.0));
+    std::vector<float> freqs;
+    conv_->Frequencies(freqs);
+    // column-major, since gnuplot output is written band by band
+    result_ = SpectrogramPtr(
+        new Spectrogram(freqs, freq_analysis::kColumnMajor));
   }
 
   bool ReadData(std::string& filename) {
-    std::ifstream datafile(filename.c_str());
-    if (!datafile) {
-      std::cerr << "cannot open file: " << filename << std::endl;
+    TraceScope trace("ReadData");
+    ImuDataReader reader;
+    return reader.Read(filename, data_);
+  }
+
+  bool ReadBinary(std::string& filename, float start, float end) {
+    TraceScope trace("ReadBinary");
+    ColumnarLogReader reader;
+    if (!reader.Open(filename)) {
       return false;
     }
-    std::string str;
-    while (getline(datafile, str)) {
-      std::vector<std::string> split_str;
-      boost::split(split_str, str, boost::is_any_of(" "));
-      // data line is asuumed to be (time acc.x y z gyro.x y z)
-      if (split_str.size() != 7) {
-        continue;
-      }
-      // when line starts at # then it is a comment line
-      if (split_str[0].at(0) == '#') {
-        continue;
+    // gyro is not used, only time and acc are loaded
+    const char* names[] = {"time", "acc.x", "acc.y", "acc.z"};
+    std::vector<size_t> columns;
+    for (size_t i = 0; i < 4; i++) {
+      int idx = reader.ColumnIndex(names[i]);
+      if (idx < 0) {
+        std::cerr << "missing column: " << names[i] << std::endl;
+        return false;
       }
-      // reading
-      time_list_.push_back(boost::lexical_cast<float>(split_str[0]));
-
-      std::vector<float> acc;
-      for (size_t i = 1; i < 4; i++) {
-        acc.push_back(boost::lexical_cast<float>(split_str[i]));
-      }
-      acc_list_.push_back(acc);
-
-      std::vector<float> gyro;
-      for (size_t i = 4; i < 7; i++) {
-        gyro.push_back(boost::lexical_cast<float>(split_str[i]));
-      }
-      gyro_list_.push_back(gyro);
+      columns.push_back(idx);
     }
-    return true;
+    std::vector<std::vector<float> > values;
+    // Proc also converts first sample past end, as for text data
+    reader.Read(start, end, columns, values, 1);
+    data_.clear();
+    data_.time.swap(values[0]);
+    data_.acc_x.swap(values[1]);
+    data_.acc_y.swap(values[2]);
+    data_.acc_z.swap(values[3]);
+    return data_.size() > 0;
   }
 
   void Proc(float start = 0.0, float end = -1.0) {
+    TraceScope trace("Proc");
     std::cout << "Proc start" << std::endl;
     float indicate_time_step = 10.0;
     float next_time = indicate_time_step;
     if (end < 0.0) {
-      end = time_list_[time_list_.size()-1];
+      end = data_.time[data_.size()-1];
     }
 
     float start_proc = start + time_offset_ * 2.0;
-    for (size_t i = 0; i < time_list_.size(); i++) {
-      float time = time_list_[i];
+    std::vector<std::vector<float> > derived;
+    AccNorm_(derived);
+    const std::vector<float>& abs_acc_list = derived[0];
+    for (size_t i = 0; i < data_.size(); i++) {
+      float time = data_.time[i];
       if (time > next_time) {
         std::cout << "Proc at " << next_time << "[s]" << std::endl;
         next_time += indicate_time_step;
@@ -82,11 +117,7 @@ class SampleDataReader {
         continue;
       }
 
-      float acc_x = acc_list_[i][0];
-      float acc_y = acc_list_[i][1];
-      float acc_z = acc_list_[i][2];
-      float abs_acc =
-          sqrt(acc_x * acc_x + acc_y * acc_y + acc_z * acc_z);
+      float abs_acc = abs_acc_list[i];
       conv_->AddValue(time, abs_acc);
 
       input_time_list_.push_back(time);
@@ -95,8 +126,7 @@ class SampleDataReader {
       if (time > start_proc) {
         std::vector<float> result;
         conv_->Convert(result);
-        result_time_list_.push_back(time - time_offset_);
-        result_list_.push_back(result);
+        result_->Append(time - time_offset_, result);
       }
 
       if (time > end) {
@@ -106,99 +136,341 @@ class SampleDataReader {
     std::cout << "Proc finish" << std::endl;
   }
 
-  void WriteResult(std::string& filename) {
-    std::ofstream resultfile(filename.c_str());
+  // Offline version of Proc, converting segments of input on separate
+  // threads. Results are identical to Proc.
+  void ProcParallel(float start, float end, size_t threads) {
+    TraceScope trace("ProcParallel");
+    std::cout << "Proc start (" << threads << " threads)" << std::endl;
+    if (end < 0.0) {
+      end = data_.time[data_.size()-1];
+    }
+
+    float start_proc = start + time_offset_ * 2.0;
+    std::vector<std::vector<float> > derived;
+    AccNorm_(derived);
+    const std::vector<float>& abs_acc_list = derived[0];
+    size_t first_convert = 0;
+    bool found = false;
+    for (size_t i = 0; i < data_.size(); i++) {
+      float time = data_.time[i];
+      if (time < start) {
+        continue;
+      }
+      float abs_acc = abs_acc_list[i];
+      input_time_list_.push_back(time);
+      input_list_.push_back(abs_acc);
+      if (!found && time > start_proc) {
+        first_convert = input_list_.size() - 1;
+        found = true;
+      }
+      if (time > end) {
+        break;
+      }
+    }
+    if (!found) {
+      first_convert = input_list_.size();
+    }
+
+    ParallelTransform transform(conv_->Bank(), buf_length_, time_offset_);
+    transform.Run(input_time_list_, input_list_, first_convert, threads,
+                  *result_);
+    std::cout << "Proc finish" << std::endl;
+  }
+
+  // Streaming version of Proc, reading lines from input and writing
+  // each row as soon as it is available. Reading, conversion and writing
+  // run on separate threads of ConversionPipeline. Memory is bounded by
+  // buffer of converter and queues. Spectrogram for gnuplot is written
+  // time by time.
+  bool ProcStream(std::istream& input, std::string& resultname,
+                  ResultWriterPtr writer,
+                  std::string& inputname, std::string& plotname,
+                  float start = 0.0, float end = -1.0) {
     std::vector<float> freqs;
     conv_->Frequencies(freqs);
-    resultfile << "# time";
-    for (size_t i = 0; i < freqs.size(); i++) {
-      resultfile << " " << freqs[i];
+    std::ofstream inputfile(inputname.c_str());
+    std::ofstream plotfile(plotname.c_str());
+    if (!writer->Open(resultname, freqs) || !inputfile || !plotfile) {
+      std::cerr << "cannot open output files" << std::endl;
+      return false;
     }
-    resultfile << std::endl;
 
-    for (size_t i = 0; i < result_time_list_.size(); i++) {
-      resultfile << result_time_list_[i];
-      for (size_t j = 0; j < result_list_[i].size(); j++) {
-        resultfile << " " << result_list_[i][j];
+    std::cout << "Proc start" << std::endl;
+    float indicate_time_step = 10.0;
+    float next_time = indicate_time_step;
+    float start_proc = start + time_offset_ * 2.0;
+    float fields[ImuDataReader::kFields];
+    bool finished = false;
+    std::string str;
+
+    ConversionPipeline::Source source = [&](PipelineSample& sample) {
+      TraceScope trace("ReadLine");
+      while (!finished && getline(input, str)) {
+        if (!ImuDataReader::ParseLine(str.data(), str.data() + str.size(),
+                                      fields)) {
+          continue;
+        }
+        float time = fields[0];
+        if (time > next_time) {
+          std::cout << "Proc at " << next_time << "[s]" << std::endl;
+          next_time += indicate_time_step;
+        }
+        if (time < start) {
+          continue;
+        }
+
+        float abs_acc = sqrt(fields[1] * fields[1] + fields[2] * fields[2]
+                             + fields[3] * fields[3]);
+        // flushed per row, so followers of output files see it at once
+        inputfile << time << " " << abs_acc << '\n' << std::flush;
+        sample.time = time;
+        sample.value = abs_acc;
+        sample.convert = time > start_proc;
+        finished = end >= 0.0 && time > end;
+        return true;
       }
-      resultfile << std::endl;
+      return false;
+    };
+
+    ConversionPipeline::Sink sink =
+        [&](float time, const std::vector<float>& result) {
+      TraceScope trace("WriteRow");
+      float result_time = time - time_offset_;
+      writer->Write(result_time, result);
+      writer->Flush();
+      for (size_t j = 0; j < result.size(); j++) {
+        plotfile << result_time << " " << freqs[j] << " "
+                 << result[j] << '\n';
+      }
+      plotfile << '\n' << std::flush;
+    };
+
+    ConversionPipeline pipeline(conv_);
+    pipeline.Run(source, sink);
+    std::cout << "Proc finish" << std::endl;
+
+    const std::vector<StageStats>& stats = pipeline.Stats();
+    for (size_t i = 0; i < stats.size(); i++) {
+      std::cout << stats[i].name << ": " << stats[i].items << " items, "
+                << stats[i].busy_seconds << "[s] busy, "
+                << stats[i].Throughput() << " items/s" << std::endl;
     }
+    std::cout << "wall: " << pipeline.WallSeconds() << "[s]" << std::endl;
+    return writer->Close();
+  }
+
+  bool WriteResult(std::string& filename, ResultWriterPtr writer) {
+    TraceScope trace("WriteResult");
+    return writer->WriteAll(filename, *result_);
+  }
+
+  bool WriteStats(std::string& filename) {
+    return conv_->DumpStats(filename);
+  }
+
+  // calls of converter are recorded until sample is destroyed
+  bool Record(std::string& filename) {
+    CallRecorderPtr recorder(new CallRecorder());
+    return recorder->Open(filename) && conv_->SetRecorder(recorder);
   }
 
   void WriteInput(std::string& filename) {
+    TraceScope trace("WriteInput");
     std::ofstream resultfile(filename.c_str());
     for (size_t i = 0; i < input_list_.size(); i++) {
       resultfile << input_time_list_[i] << " "
-                 << input_list_[i] << std::endl;
+                 << input_list_[i] << '\n';
     }
   }
 
   void WriteGnuplot3D(std::string& filename) {
+    TraceScope trace("WriteGnuplot3D");
     std::ofstream resultfile(filename.c_str());
-    std::vector<float> freqs;
-    conv_->Frequencies(freqs);
+    const std::vector<float>& freqs = result_->Frequencies();
+    const std::vector<float>& times = result_->Times();
 
     for (size_t i = 0; i < freqs.size(); i++) {
       float freq = freqs[i];
-      for (size_t j = 0; j < result_time_list_.size(); j++) {
-        resultfile << result_time_list_[j] << " "
+      SpectrogramView band = result_->Band(i);
+      for (size_t j = 0; j < band.size(); j++) {
+        resultfile << times[j] << " "
                    << freq << " "
-                   << result_list_[j][i] << std::endl;
+                   << band[j] << '\n';
       }
-      resultfile << std::endl;
+      resultfile << '\n';
     }
   }
 
 
  private:
+  // magnitude of acc for all rows
+  void AccNorm_(std::vector<std::vector<float> >& derived) {
+    std::vector<DerivedChannel> channels(1, freq_analysis::kAccNorm);
+    ImuPreprocessor preprocessor(channels);
+    preprocessor.Process(data_, 0, data_.size(), derived);
+  }
+
   WaveletConverterPtr conv_;
-  std::vector<float> time_list_;
-  std::vector<std::vector<float> > acc_list_;
-  std::vector<std::vector<float> > gyro_list_;
+  ImuColumns data_;
   float time_offset_;
+  size_t buf_length_;
 
   std::vector<float> input_time_list_;
   std::vector<float> input_list_;
 
-  std::vector<float> result_time_list_;
-  std::vector<std::vector<float> > result_list_;
+  SpectrogramPtr result_;
 };
 
+void WriteTrace(const std::string& filename) {
+  if (Tracer::DroppedCount() > 0) {
+    std::cerr << Tracer::DroppedCount() << " trace events dropped"
+              << std::endl;
+  }
+  Tracer::Write(filename);
+}
+
 int main(int argc, char** argv) {
   std::string filename;
   float start = 0.0;
   float end = -1.0;
-  if (argc < 2) {
+  bool stream = false;
+  std::string format("text");
+  size_t threads = 1;
+  std::string statsfile;
+  std::string tracefile;
+  std::string recordfile;
+  int arg = 1;
+  while (argc > arg && std::string(argv[arg]).compare(0, 2, "--") == 0) {
+    std::string option(argv[arg]);
+    if (option == "--stream") {
+      stream = true;
+    } else if (option == "--format" && argc > arg + 1) {
+      format = std::string(argv[++arg]);
+    } else if (option == "--threads" && argc > arg + 1) {
+      threads = atoi(argv[++arg]);
+    } else if (option == "--stats" && argc > arg + 1) {
+      statsfile = std::string(argv[++arg]);
+    } else if (option == "--trace" && argc > arg + 1) {
+      tracefile = std::string(argv[++arg]);
+    } else if (option == "--record" && argc > arg + 1) {
+      recordfile = std::string(argv[++arg]);
+    } else {
+      std::cerr << "unknown option: " << option << std::endl;
+      return 1;
+    }
+    arg++;
+  }
+  ResultWriterPtr writer = freq_analysis::CreateResultWriter(format);
+  if (argc - arg < 1 || !writer) {
     std::cerr
-        << "usage: sample_walking <data file> [start time] [end time]"
+        << "usage: sample_walking [--stream]"
+        << " [--format text|npy|gnuplot|mapped]"
+        << " [--threads N] [--stats file] [--trace file] [--record file]"
+        << " <data file|-> [start time] [end time]"
         << std::endl;
     return 1;
-  } else if (argc >= 4) {
+  } else if (argc - arg >= 3) {
     try {
-      start = boost::lexical_cast<float>(std::string(argv[2]));
-      end = boost::lexical_cast<float>(std::string(argv[3]));
+      start = boost::lexical_cast<float>(std::string(argv[arg + 1]));
+      end = boost::lexical_cast<float>(std::string(argv[arg + 2]));
     } catch (boost::bad_lexical_cast& ex) {
       std::cerr << "invalid start or end time." << std::endl;
       return 1;
     }
   }
-  filename = std::string(argv[1]);
+  filename = std::string(argv[arg]);
+
+  std::string resultfile("result_walking.dat");
+  if (format == "npy") {
+    resultfile = "result_walking.npy";
+  } else if (format == "gnuplot") {
+    resultfile = "result_walking.bin";
+  } else if (format == "mapped") {
+    resultfile = "result_walking.spec";
+  }
+  std::string targetfile("input_walking.dat");
+  std::string plotfile("plot_walking.dat");
+
+  if (!tracefile.empty()) {
+    // room for every event of example data
+    Tracer::SetBufferEvents(1 << 18);
+    Tracer::Enable(true);
+    Tracer::SetThreadName("main");
+  }
+
+  if (!statsfile.empty() && threads > 1) {
+    // segments are converted by their own converters
+    std::cerr << "--stats is ignored with --threads" << std::endl;
+    statsfile.clear();
+  }
+#ifndef FREQ_ANALYSIS_ENABLE_STATS
+  if (!statsfile.empty()) {
+    std::cerr << "counters of --stats are 0, configure with"
+              << " -DFREQ_ANALYSIS_ENABLE_STATS=ON" << std::endl;
+  }
+#endif
 
   SampleDataReader sample;
-  if (!sample.ReadData(filename)) {
+  if (!recordfile.empty()) {
+    if (threads > 1) {
+      std::cerr << "--record is ignored with --threads" << std::endl;
+    } else if (!sample.Record(recordfile)) {
+      return 1;
+    }
+  }
+  // "-" reads from stdin, which is always streamed
+  if (filename == "-") {
+    bool ok = sample.ProcStream(std::cin, resultfile, writer,
+                                targetfile, plotfile, start, end);
+    if (!statsfile.empty()) {
+      sample.WriteStats(statsfile);
+    }
+    if (!tracefile.empty()) {
+      WriteTrace(tracefile);
+    }
+    return ok ? 0 : 1;
+  }
+  if (stream) {
+    std::ifstream datafile(filename.c_str());
+    if (!datafile) {
+      std::cerr << "invalid or missing data file: " << filename << std::endl;
+      return 1;
+    }
+    bool ok = sample.ProcStream(datafile, resultfile, writer,
+                                targetfile, plotfile, start, end);
+    if (!statsfile.empty()) {
+      sample.WriteStats(statsfile);
+    }
+    if (!tracefile.empty()) {
+      WriteTrace(tracefile);
+    }
+    return ok ? 0 : 1;
+  }
+
+  // binary columnar log created by dat2bin is read only in time range
+  bool binary = filename.size() > 4 &&
+      filename.compare(filename.size() - 4, 4, ".bin") == 0;
+  bool read_ok = binary ?
+      sample.ReadBinary(filename, start, end) : sample.ReadData(filename);
+  if (!read_ok) {
     std::cerr << "invalid or missing data file: " << filename << std::endl;
     return 1;
   }
-  sample.Proc(start, end);
-
-  std::string resultfile("result_walking.dat");
-  sample.WriteResult(resultfile);
+  if (threads > 1) {
+    sample.ProcParallel(start, end, threads);
+  } else {
+    sample.Proc(start, end);
+  }
 
-  std::string targetfile("input_walking.dat");
+  sample.WriteResult(resultfile, writer);
   sample.WriteInput(targetfile);
-
-  std::string plotfile("plot_walking.dat");
   sample.WriteGnuplot3D(plotfile);
+  if (!statsfile.empty()) {
+    sample.WriteStats(statsfile);
+  }
+  if (!tracefile.empty()) {
+    WriteTrace(tracefile);
+  }
 
   return 0;
 }
@@ -0,0 +1,39 @@
+/// @file batch_layout.hpp
+/// @brief Output files of batch processing mirroring tree of input files
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_BATCH_LAYOUT_HPP_
+#define FREQ_ANALYSIS_BATCH_LAYOUT_HPP_
+
+#include <vector>
+#include <string>
+
+namespace freq_analysis {
+
+/// @brief Maps each input file to output file at same path relative to
+/// common root of inputs, so that e.g. a/left_leg.dat and b/left_leg.dat
+/// are written to <out>/a/left_leg<suffix> and <out>/b/left_leg<suffix>.
+class BatchLayout {
+ public:
+  BatchLayout(const std::string& output_dir, const std::string& suffix);
+
+  bool Plan(const std::vector<std::string>& inputs);
+
+  const std::string& Root() const;
+  const std::vector<std::string>& Inputs() const;
+  const std::vector<std::string>& Outputs() const;
+
+  static std::string CommonRoot(const std::vector<std::string>& paths);
+
+ private:
+  std::string output_dir_;
+  std::string suffix_;
+  std::string root_;
+  std::vector<std::string> input_list_;
+  std::vector<std::string> output_list_;
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_BATCH_LAYOUT_HPP_
@@ -0,0 +1,140 @@
+/// @file call_recorder.hpp
+/// @brief Binary trace of WaveletConverter calls for replay
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_CALL_RECORDER_HPP_
+#define FREQ_ANALYSIS_CALL_RECORDER_HPP_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// @brief Configuration of recorded converter
+struct CallTraceConfig {
+  float start;
+  float step;
+  uint32_t band_count;
+  float sigma;
+  float table_resolution;
+  uint32_t max_buf_length;
+  float center_t;
+};
+
+/// File layout, all values little endian:
+///   header   CallTraceHeader
+///   records  1 byte CallType followed by its arguments
+///     kCallAddValue       float time, float value
+///     kCallClearValue
+///     kCallConvert        [band_count x float result]
+///     kCallConvertWithin  double budget, uint8 complete,
+///                         [band_count x float result]
+///     kCallEnablePruning  float threshold, uint32 refresh_interval
+///     kCallDisablePruning
+///     kCallSetPriority    uint32 count, count x uint32 index
+/// Results are written only if kCallTraceResults is set in flags.
+struct CallTraceHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t band_count;
+  float start;
+  float step;
+  float sigma;
+  float table_resolution;
+  uint32_t max_buf_length;
+  float center_t;
+  uint64_t record_count;
+  uint8_t reserved[16];
+};
+
+enum CallType {
+  kCallAddValue = 1,
+  kCallClearValue,
+  kCallConvert,
+  kCallConvertWithin,
+  kCallEnablePruning,
+  kCallDisablePruning,
+  kCallSetPriority
+};
+
+const uint32_t kCallTraceResults = 1;
+
+/// @brief Writer of calls of one converter, attached by
+/// WaveletConverter::SetRecorder. Not thread safe, same as converter.
+class CallRecorder {
+ public:
+  CallRecorder();
+  ~CallRecorder();
+
+  bool Open(const std::string& filename, bool record_results = true);
+  bool Start(const CallTraceConfig& config);
+  bool Close();
+  bool Started() const;
+  uint64_t RecordCount() const;
+
+  void AddValue(float time, float value);
+  void ClearValue();
+  void Convert(const std::vector<float>& result);
+  void ConvertWithin(double budget, bool complete,
+                     const std::vector<float>& result);
+  void EnablePruning(float threshold, uint32_t refresh_interval);
+  void DisablePruning();
+  void SetPriority(const std::vector<size_t>& order);
+
+ private:
+  FILE* fp_;
+  CallTraceHeader header_;
+  bool started_;
+  std::vector<char> buffer_;
+
+  void WriteType_(CallType type);
+
+  CallRecorder(const CallRecorder&);
+  CallRecorder& operator=(const CallRecorder&);
+};
+
+typedef boost::shared_ptr<CallRecorder> CallRecorderPtr;
+
+/// @brief One recorded call. Results and priority indices are stored
+/// in CallTrace, referred by offset and count.
+struct CallRecord {
+  CallType type;
+  bool complete;     ///< kCallConvertWithin
+  float time;        ///< kCallAddValue
+  float value;       ///< kCallAddValue, threshold of kCallEnablePruning
+  double budget;     ///< kCallConvertWithin
+  uint32_t offset;   ///< first element in Results() or Indices()
+  uint32_t count;    ///< results, priority indices or refresh interval
+};
+
+/// @brief Trace read into memory, so replay does not wait for file
+class CallTrace {
+ public:
+  CallTrace();
+
+  bool Read(const std::string& filename);
+
+  const CallTraceConfig& Config() const;
+  bool HasResults() const;
+  size_t size() const;
+  const CallRecord& operator[](size_t i) const;
+  const float* Results(const CallRecord& record) const;
+  const uint32_t* Indices(const CallRecord& record) const;
+
+ private:
+  CallTraceConfig config_;
+  bool has_results_;
+  std::vector<CallRecord> record_list_;
+  std::vector<float> result_list_;
+  std::vector<uint32_t> index_list_;
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_CALL_RECORDER_HPP_
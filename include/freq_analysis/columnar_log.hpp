@@ -0,0 +1,110 @@
+/// @file columnar_log.hpp
+/// @brief Binary columnar log with time index
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_COLUMNAR_LOG_HPP_
+#define FREQ_ANALYSIS_COLUMNAR_LOG_HPP_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// File layout, all values little endian:
+///   header     ColumnarLogHeader
+///   names      column_count x char[16]
+///   blocks     block_count x (column_count x rows x float), column by column
+///   index      block_count x ColumnarLogIndex
+/// The first column is time and must be non-decreasing. It is stored as
+/// float offset from first_time of its block, so long logs keep fine
+/// time resolution.
+struct ColumnarLogHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t column_count;
+  uint32_t block_rows;
+  uint64_t row_count;
+  uint64_t block_count;
+  uint64_t index_offset;
+  uint8_t reserved[24];
+};
+
+/// @brief Index entry for each block
+struct ColumnarLogIndex {
+  double first_time;
+  double last_time;
+  uint32_t rows;
+  uint32_t reserved;
+  uint64_t offset;
+};
+
+/// @brief Writer of columnar log, rows are buffered per block
+class ColumnarLogWriter {
+ public:
+  static const size_t kNameLength = 16;
+
+  ColumnarLogWriter();
+  ~ColumnarLogWriter();
+
+  bool Open(const std::string& filename,
+            const std::vector<std::string>& column_names,
+            uint32_t block_rows = 4096);
+  void Write(const float* row);
+  void Write(double time, const float* values);
+  bool Close();
+
+ private:
+  FILE* fp_;
+  ColumnarLogHeader header_;
+  std::vector<float> block_;
+  std::vector<double> time_list_;
+  uint32_t rows_;
+  std::vector<ColumnarLogIndex> index_list_;
+
+  void FlushBlock_();
+
+  ColumnarLogWriter(const ColumnarLogWriter&);
+  ColumnarLogWriter& operator=(const ColumnarLogWriter&);
+};
+
+/// @brief Memory-mapped reader of columnar log
+class ColumnarLogReader {
+ public:
+  ColumnarLogReader();
+  ~ColumnarLogReader();
+
+  bool Open(const std::string& filename);
+  void Close();
+
+  size_t ColumnCount() const;
+  uint64_t RowCount() const;
+  int ColumnIndex(const std::string& name) const;
+  const std::vector<std::string>& ColumnNames() const;
+
+  uint64_t Read(double start, double end, const std::vector<size_t>& columns,
+                std::vector<std::vector<float> >& result,
+                size_t rows_after = 0,
+                std::vector<double>* times = NULL) const;
+
+ private:
+  const char* addr_;
+  size_t length_;
+  const ColumnarLogHeader* header_;
+  const ColumnarLogIndex* index_;
+  std::vector<std::string> name_list_;
+
+  ColumnarLogReader(const ColumnarLogReader&);
+  ColumnarLogReader& operator=(const ColumnarLogReader&);
+};
+
+typedef boost::shared_ptr<ColumnarLogWriter> ColumnarLogWriterPtr;
+typedef boost::shared_ptr<ColumnarLogReader> ColumnarLogReaderPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_COLUMNAR_LOG_HPP_
@@ -0,0 +1,80 @@
+/// @file conversion_driver.hpp
+/// @brief Periodic background conversion with WaveletConverter
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_CONVERSION_DRIVER_HPP_
+#define FREQ_ANALYSIS_CONVERSION_DRIVER_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/wavelet_converter.hpp"
+
+namespace freq_analysis {
+
+/// @brief Timing statistics of ConversionDriver, times in [s]
+struct DriverStats {
+  uint64_t ticks;
+  uint64_t conversions;
+  uint64_t missed_deadlines;
+  double mean_jitter;
+  double max_jitter;
+};
+
+/// @brief Runs WaveletConverter::Convert on its own thread at fixed rate
+/// and delivers each result to registered callbacks. Callbacks run on
+/// driver thread and may call AddCallback, but must not call Stop, which
+/// joins driver thread.
+class ConversionDriver {
+ public:
+  /// @brief Callback with time stamp of latest value and result
+  typedef std::function<void (float, const std::vector<float>&)> Callback;
+
+  ConversionDriver(WaveletConverterPtr converter, float rate);
+  ~ConversionDriver();
+
+  void AddCallback(const Callback& callback);
+  void AddValue(float time, float value);
+  bool Start();
+  void Stop();
+  DriverStats Stats();
+
+ private:
+  WaveletConverterPtr converter_;
+  double period_;
+
+  std::mutex converter_mutex_;
+  float latest_time_;
+  bool has_value_;
+
+  std::mutex callback_mutex_;
+  std::vector<Callback> callback_list_;
+
+  std::thread thread_;
+  std::atomic<bool> running_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cond_;
+
+  std::mutex stats_mutex_;
+  DriverStats stats_;
+  double jitter_sum_;
+
+  void Run_();
+
+  ConversionDriver(const ConversionDriver&);
+  ConversionDriver& operator=(const ConversionDriver&);
+};
+
+typedef boost::shared_ptr<ConversionDriver> ConversionDriverPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_CONVERSION_DRIVER_HPP_
@@ -0,0 +1,46 @@
+/// @file filter_bank.hpp
+/// @brief Immutable set of gabor filters shared by converters
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_FILTER_BANK_HPP_
+#define FREQ_ANALYSIS_FILTER_BANK_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/gabor_wavelet.hpp"
+
+namespace freq_analysis {
+
+/// @brief Gabor filters with frequencies in geometric series.
+/// Not modified after construction, so one instance can be shared by
+/// converters on different threads.
+class FilterBank {
+ public:
+  FilterBank(float start, float step, size_t length, float sigma = 2.0,
+             float table_resolution = 8.0);
+
+  const std::vector<GaborFilterPtr>& Filters() const;
+  const std::vector<float>& Frequencies() const;
+  size_t size() const;
+  float Start() const;
+  float Step() const;
+  float Sigma() const;
+  float TableResolution() const;
+
+ private:
+  std::vector<GaborFilterPtr> filter_list_;
+  std::vector<float> freq_list_;
+  float start_;
+  float step_;
+  float sigma_;
+  float table_resolution_;
+};
+
+typedef boost::shared_ptr<const FilterBank> FilterBankPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_FILTER_BANK_HPP_
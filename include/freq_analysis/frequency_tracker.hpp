@@ -0,0 +1,64 @@
+/// @file frequency_tracker.hpp
+/// @brief Dominant frequency tracking by coarse-to-fine Gabor filtering
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_FREQUENCY_TRACKER_HPP_
+#define FREQ_ANALYSIS_FREQUENCY_TRACKER_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <list>
+#include <map>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/gabor_wavelet.hpp"
+
+namespace freq_analysis {
+
+/// @brief Result of FrequencyTracker::Track
+struct TrackResult {
+  float frequency;
+  float magnitude;
+  float confidence;
+  size_t evaluated;
+};
+
+/// @brief Finds dominant frequency with a coarse geometric grid of
+/// GaborFilters, refined around the peak with filters created on demand.
+class FrequencyTracker {
+ public:
+  FrequencyTracker(float min_freq, float max_freq, size_t coarse_length,
+                   float resolution, float sigma = 2.0,
+                   size_t cache_size = 32);
+
+  TrackResult Track(const std::list<float>& time_list,
+                    const std::list<float>& value_list,
+                    float time_offset);
+  void Frequencies(std::vector<float>& result);
+  size_t CachedFilters() const;
+
+ private:
+  typedef std::pair<int64_t, GaborFilterPtr> CacheEntry;
+
+  std::vector<GaborFilterPtr> filter_list_;
+  std::vector<float> freq_list_;
+  float min_freq_;
+  float max_freq_;
+  float resolution_;
+  float sigma_;
+
+  size_t cache_size_;
+  std::list<CacheEntry> cache_list_;
+  std::map<int64_t, std::list<CacheEntry>::iterator> cache_map_;
+
+  GaborFilterPtr CachedFilter_(int64_t key);
+};
+
+typedef boost::shared_ptr<FrequencyTracker> FrequencyTrackerPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_FREQUENCY_TRACKER_HPP_
@@ -20,13 +20,14 @@ class GaborFilter {
 public:
   GaborFilter(float freq, float sigma, float time_step);
 
-  float Filter(const std::list<float> time_list,
-               const std::list<float> value_list,
-               float time_offset);
+  float Filter(const std::list<float>& time_list,
+               const std::list<float>& value_list,
+               float time_offset) const;
 
-  std::pair<float, float> ApproxValue(float time);
+  std::pair<float, float> ApproxValue(float time) const;
   
   void Status();
+  size_t MemoryBytes() const;
 
   GaborFilter(const GaborFilter& obj);
   GaborFilter& operator=(const GaborFilter& obj);
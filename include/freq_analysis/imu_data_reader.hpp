@@ -0,0 +1,62 @@
+/// @file imu_data_reader.hpp
+/// @brief Parallel reader of imu data files
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_IMU_DATA_READER_HPP_
+#define FREQ_ANALYSIS_IMU_DATA_READER_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// @brief Imu data stored column by column
+struct ImuColumns {
+  std::vector<float> time;
+  std::vector<float> acc_x;
+  std::vector<float> acc_y;
+  std::vector<float> acc_z;
+  std::vector<float> gyro_x;
+  std::vector<float> gyro_y;
+  std::vector<float> gyro_z;
+
+  size_t size() const;
+  void clear();
+  void reserve(size_t length);
+  void push_back(const float* fields);
+  void append(const ImuColumns& obj);
+};
+
+/// @brief Reader of text data file with lines of
+/// "time acc.x acc.y acc.z gyro.x gyro.y gyro.z",
+/// lines starting with # are comments.
+///
+/// The file is mapped into memory, split into line-aligned chunks and
+/// the chunks are parsed on separate threads.
+class ImuDataReader {
+ public:
+  static const size_t kFields = 7;
+
+  explicit ImuDataReader(size_t threads = 0);
+
+  bool Read(const std::string& filename, ImuColumns& data);
+  uint64_t BytesRead() const;
+
+  static bool ParseLine(const char* begin, const char* end, float* fields);
+  static void ParseChunk(const char* begin, const char* end,
+                         ImuColumns& data);
+
+ private:
+  size_t threads_;
+  uint64_t bytes_read_;
+};
+
+typedef boost::shared_ptr<ImuDataReader> ImuDataReaderPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_IMU_DATA_READER_HPP_
@@ -0,0 +1,66 @@
+/// @file imu_preprocessor.hpp
+/// @brief Derived signals of imu data computed block by block
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_IMU_PREPROCESSOR_HPP_
+#define FREQ_ANALYSIS_IMU_PREPROCESSOR_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/imu_data_reader.hpp"
+
+namespace freq_analysis {
+
+/// @brief Signals derived from imu data
+enum DerivedChannel {
+  kAccNorm,
+  kGyroNorm,
+  kAccX,
+  kAccY,
+  kAccZ,
+  kGyroX,
+  kGyroY,
+  kGyroZ,
+  kAccGravity,  ///< acc projected onto low-pass gravity estimate
+};
+
+/// @brief Computes configured derived channels over whole blocks of
+/// ImuColumns, vectorized with SSE where available.
+class ImuPreprocessor {
+ public:
+  explicit ImuPreprocessor(const std::vector<DerivedChannel>& channels,
+                           float gravity_time_constant = 1.0);
+
+  void Process(const ImuColumns& data, size_t begin, size_t end,
+               std::vector<std::vector<float> >& result);
+  size_t ChannelCount() const;
+  void Reset();
+
+  static void Norm(const float* x, const float* y, const float* z,
+                   float* result, size_t length);
+  static void Dot(const float* x, const float* y, const float* z,
+                  const float* u, const float* v, const float* w,
+                  float* result, size_t length);
+
+ private:
+  std::vector<DerivedChannel> channel_list_;
+  float time_constant_;
+
+  bool has_gravity_;
+  float last_time_;
+  float gravity_[3];
+  std::vector<float> unit_x_;
+  std::vector<float> unit_y_;
+  std::vector<float> unit_z_;
+
+  void EstimateGravity_(const ImuColumns& data, size_t begin, size_t end);
+};
+
+typedef boost::shared_ptr<ImuPreprocessor> ImuPreprocessorPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_IMU_PREPROCESSOR_HPP_
@@ -0,0 +1,122 @@
+/// @file mapped_spectrogram.hpp
+/// @brief Spectrogram stored in chunked memory-mapped file
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_MAPPED_SPECTROGRAM_HPP_
+#define FREQ_ANALYSIS_MAPPED_SPECTROGRAM_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/spectrogram.hpp"
+#include "freq_analysis/result_writer.hpp"
+
+namespace freq_analysis {
+
+/// File layout, all values little endian:
+///   header     MappedSpectrogramHeader
+///   freqs      band_count x float
+///   (padding to page boundary, data_offset)
+///   chunks     chunk_count x chunk_bytes, each chunk holds
+///                MappedSpectrogramIndex
+///                times   chunk_rows x float
+///                values  chunk_rows x band_count x float, row by row
+/// Chunks have fixed size, so chunk i starts at data_offset + i * chunk_bytes
+/// and index entries are found without parsing.
+/// Header is rewritten whenever a chunk is completed, thus rows of
+/// completed chunks are readable while file is still written.
+struct MappedSpectrogramHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t band_count;
+  uint32_t chunk_rows;
+  uint64_t row_count;
+  uint64_t chunk_count;
+  uint64_t chunk_bytes;
+  uint64_t data_offset;
+  uint8_t reserved[16];
+};
+
+/// @brief Index entry at head of each chunk
+struct MappedSpectrogramIndex {
+  float first_time;
+  float last_time;
+  uint32_t rows;
+  uint32_t reserved;
+};
+
+/// @brief Writer appending rows to mapped file. Only the current chunk is
+/// mapped, so memory footprint does not depend on length of recording.
+class MappedSpectrogramWriter : public ResultWriter {
+ public:
+  explicit MappedSpectrogramWriter(uint32_t chunk_rows = 4096);
+  virtual ~MappedSpectrogramWriter();
+
+  virtual bool Open(const std::string& filename,
+                    const std::vector<float>& freqs);
+  virtual void Write(float time, const std::vector<float>& values);
+  virtual bool Close();
+
+  uint64_t RowCount() const;
+  size_t MappedBytes() const;
+
+ private:
+  int fd_;
+  uint32_t chunk_rows_;
+  MappedSpectrogramHeader header_;
+  char* chunk_;
+  bool failed_;
+
+  bool MapChunk_();
+  void UnmapChunk_();
+  bool WriteHeader_();
+
+  MappedSpectrogramWriter(const MappedSpectrogramWriter&);
+  MappedSpectrogramWriter& operator=(const MappedSpectrogramWriter&);
+};
+
+/// @brief Memory-mapped reader of spectrogram file. Counts of header are
+/// copied at Open, so a file still being written shows the rows completed
+/// until then, and Refresh maps rows completed later.
+class MappedSpectrogramReader {
+ public:
+  MappedSpectrogramReader();
+  ~MappedSpectrogramReader();
+
+  bool Open(const std::string& filename);
+  bool Refresh();
+  void Close();
+
+  size_t Bands() const;
+  uint64_t RowCount() const;
+  uint64_t ChunkCount() const;
+  const std::vector<float>& Frequencies() const;
+
+  float Time(uint64_t row) const;
+  SpectrogramView Row(uint64_t row) const;
+  uint64_t Read(float start, float end, Spectrogram& result) const;
+
+ private:
+  const char* addr_;
+  size_t length_;
+  std::string filename_;
+  MappedSpectrogramHeader header_;
+  std::vector<float> freq_list_;
+
+  bool Map_(const std::string& filename);
+  const MappedSpectrogramIndex* Chunk_(uint64_t chunk) const;
+
+  MappedSpectrogramReader(const MappedSpectrogramReader&);
+  MappedSpectrogramReader& operator=(const MappedSpectrogramReader&);
+};
+
+typedef boost::shared_ptr<MappedSpectrogramWriter> MappedSpectrogramWriterPtr;
+typedef boost::shared_ptr<MappedSpectrogramReader> MappedSpectrogramReaderPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_MAPPED_SPECTROGRAM_HPP_
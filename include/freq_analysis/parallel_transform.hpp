@@ -0,0 +1,47 @@
+/// @file parallel_transform.hpp
+/// @brief Offline conversion of long time series split over threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_PARALLEL_TRANSFORM_HPP_
+#define FREQ_ANALYSIS_PARALLEL_TRANSFORM_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/spectrogram.hpp"
+
+namespace freq_analysis {
+
+/// @brief Splits time series into segments converted on separate threads.
+///
+/// Result at each sample depends only on the last max_buf_length values
+/// in buffer of WaveletConverter, so each segment is preceded by that many
+/// values as warm-up and the stitched result is bit-identical to
+/// calling AddValue and Convert on a single converter in order.
+class ParallelTransform {
+ public:
+  ParallelTransform(FilterBankPtr bank, size_t max_buf_length,
+                    float center_t);
+
+  void Run(const std::vector<float>& times, const std::vector<float>& values,
+           size_t first_convert, size_t threads, Spectrogram& results);
+
+ private:
+  FilterBankPtr bank_;
+  size_t max_buf_length_;
+  float center_t_;
+
+  void RunSegment_(const std::vector<float>& times,
+                   const std::vector<float>& values,
+                   size_t first_convert, size_t begin, size_t end,
+                   Spectrogram& results);
+};
+
+typedef boost::shared_ptr<ParallelTransform> ParallelTransformPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_PARALLEL_TRANSFORM_HPP_
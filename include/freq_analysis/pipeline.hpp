@@ -0,0 +1,261 @@
+/// @file pipeline.hpp
+/// @brief Pipelined read, convert and write stages on separate threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_PIPELINE_HPP_
+#define FREQ_ANALYSIS_PIPELINE_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <utility>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/wavelet_converter.hpp"
+
+namespace freq_analysis {
+
+/// @brief Bounded lock-free queue for single producer and single consumer.
+/// Push() waits while the queue is full, which throttles the producer.
+/// Waiting spins for a short time and then sleeps on a condition variable,
+/// so an idle stage does not keep a core busy. The other side takes the
+/// mutex only when it sees a sleeper.
+/// Items are swapped in and out, so storage of popped items (e.g. vector
+/// capacity) is handed back to the producer instead of reallocated.
+template <typename T>
+class SpscQueue {
+ public:
+  /// @brief Constructor
+  /// @param length Capacity, rounded up to power of 2
+  explicit SpscQueue(size_t length) : head_(0), tail_(0), closed_(false),
+                                      consumer_wait_(0.0),
+                                      producer_wait_(0.0),
+                                      consumer_sleeping_(false),
+                                      producer_sleeping_(false) {
+    size_t capacity = 1;
+    while (capacity < length) {
+      capacity *= 2;
+    }
+    buffer_.resize(capacity);
+    mask_ = capacity - 1;
+  }
+
+  /// @brief Add item without waiting
+  /// @return false if full
+  bool TryPush(T& item) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_) {
+      return false;
+    }
+    std::swap(buffer_[tail & mask_], item);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Take item without waiting
+  /// @return false if empty
+  bool TryPop(T& item) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    std::swap(item, buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Add item, waiting while full
+  void Push(T& item) {
+    if (TryPush(item)) {
+      WakeConsumer_();
+      return;
+    }
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    bool pushed = false;
+    for (int i = 0; i < kSpinCount && !pushed; i++) {
+      std::this_thread::yield();
+      pushed = TryPush(item);
+    }
+    if (!pushed) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      producer_sleeping_.store(true, std::memory_order_relaxed);
+      // pairs with fence in WakeProducer_, either Pop sees the flag
+      // or TryPush sees the slot freed by Pop
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (!TryPush(item)) {
+        not_full_.wait(lock);
+      }
+      producer_sleeping_.store(false, std::memory_order_relaxed);
+    }
+    WakeConsumer_();
+    producer_wait_ += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// @brief Take item, waiting while empty
+  /// @return false if closed and empty
+  bool Pop(T& item) {
+    if (TryPop(item)) {
+      WakeProducer_();
+      return true;
+    }
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    bool ok = false;
+    bool done = false;
+    for (int i = 0; i < kSpinCount && !done; i++) {
+      std::this_thread::yield();
+      done = PopOrClosed_(item, ok);
+    }
+    if (!done) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      consumer_sleeping_.store(true, std::memory_order_relaxed);
+      // pairs with fence in WakeConsumer_
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (!PopOrClosed_(item, ok)) {
+        not_empty_.wait(lock);
+      }
+      consumer_sleeping_.store(false, std::memory_order_relaxed);
+    }
+    if (ok) {
+      WakeProducer_();
+    }
+    consumer_wait_ += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return ok;
+  }
+
+  /// @brief No more items will be pushed
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(mutex_);
+    not_empty_.notify_one();
+  }
+
+  /// @brief Time consumer waited on empty queue[s]
+  double ConsumerWait() const {
+    return consumer_wait_;
+  }
+
+  /// @brief Time producer waited on full queue[s]
+  double ProducerWait() const {
+    return producer_wait_;
+  }
+
+ private:
+  std::vector<T> buffer_;
+  size_t mask_;
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+  std::atomic<bool> closed_;
+  double consumer_wait_;
+  double producer_wait_;
+
+  // yields before sleeping, a few microseconds of handover
+  static const int kSpinCount = 64;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::atomic<bool> consumer_sleeping_;
+  std::atomic<bool> producer_sleeping_;
+
+  /// @brief Take item or detect end of queue
+  /// @return true if item was taken (ok is true) or queue is closed and
+  ///         empty (ok is false)
+  bool PopOrClosed_(T& item, bool& ok) {
+    if (TryPop(item)) {
+      ok = true;
+      return true;
+    }
+    if (closed_.load(std::memory_order_acquire)) {
+      // items pushed before Close() may still be pending
+      ok = TryPop(item);
+      return true;
+    }
+    return false;
+  }
+
+  /// @brief Wake consumer sleeping on empty queue after push
+  void WakeConsumer_() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_sleeping_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      not_empty_.notify_one();
+    }
+  }
+
+  /// @brief Wake producer sleeping on full queue after pop
+  void WakeProducer_() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (producer_sleeping_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      not_full_.notify_one();
+    }
+  }
+
+  SpscQueue(const SpscQueue&);
+  SpscQueue& operator=(const SpscQueue&);
+};
+
+/// @brief Input of converter stage
+struct PipelineSample {
+  float time;
+  float value;
+  bool convert;
+};
+
+/// @brief Output of converter stage
+struct PipelineRow {
+  float time;
+  std::vector<float> values;
+};
+
+/// @brief Throughput of each stage, busy time excludes waits on queues
+struct StageStats {
+  std::string name;
+  uint64_t items;
+  double busy_seconds;
+  double wall_seconds;
+
+  double Throughput() const {
+    return busy_seconds > 0.0 ? items / busy_seconds : 0.0;
+  }
+};
+
+/// @brief Runs reader, converter and writer stages on three threads
+/// connected by bounded queues.
+class ConversionPipeline {
+ public:
+  /// @brief Reader stage, returns false at end of input
+  typedef std::function<bool (PipelineSample&)> Source;
+  /// @brief Writer stage, called with time of latest value and result
+  typedef std::function<void (float, const std::vector<float>&)> Sink;
+
+  ConversionPipeline(WaveletConverterPtr converter,
+                     size_t queue_length = 4096);
+
+  void Run(const Source& source, const Sink& sink);
+  const std::vector<StageStats>& Stats() const;
+  double WallSeconds() const;
+
+ private:
+  WaveletConverterPtr converter_;
+  size_t queue_length_;
+  std::vector<StageStats> stats_;
+  double wall_seconds_;
+};
+
+typedef boost::shared_ptr<ConversionPipeline> ConversionPipelinePtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_PIPELINE_HPP_
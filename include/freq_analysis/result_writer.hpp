@@ -0,0 +1,99 @@
+/// @file result_writer.hpp
+/// @brief Writers of converter results in various file formats
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_RESULT_WRITER_HPP_
+#define FREQ_ANALYSIS_RESULT_WRITER_HPP_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include "freq_analysis/spectrogram.hpp"
+
+namespace freq_analysis {
+
+/// @brief Interface of writers, rows are written in order of time
+class ResultWriter {
+ public:
+  virtual ~ResultWriter() {}
+
+  virtual bool Open(const std::string& filename,
+                    const std::vector<float>& freqs) = 0;
+  virtual void Write(float time, const std::vector<float>& values) = 0;
+  virtual bool Close() = 0;
+  /// @brief Hand rows written so far to file, for readers following it
+  virtual void Flush() {}
+
+  bool WriteAll(const std::string& filename, const Spectrogram& spectrogram);
+};
+
+typedef boost::shared_ptr<ResultWriter> ResultWriterPtr;
+
+/// @brief Text rows of "time value...", header line lists frequencies.
+/// Output is buffered and flushed only by Flush or Close.
+class TextResultWriter : public ResultWriter {
+ public:
+  TextResultWriter();
+  virtual ~TextResultWriter();
+
+  virtual bool Open(const std::string& filename,
+                    const std::vector<float>& freqs);
+  virtual void Write(float time, const std::vector<float>& values);
+  virtual bool Close();
+  virtual void Flush();
+
+ private:
+  FILE* fp_;
+  std::vector<char> buffer_;
+};
+
+/// @brief NumPy .npy float32 array of shape (rows, 1 + bands),
+/// column 0 is time
+class NpyResultWriter : public ResultWriter {
+ public:
+  NpyResultWriter();
+  virtual ~NpyResultWriter();
+
+  virtual bool Open(const std::string& filename,
+                    const std::vector<float>& freqs);
+  virtual void Write(float time, const std::vector<float>& values);
+  virtual bool Close();
+  virtual void Flush();
+
+ private:
+  FILE* fp_;
+  size_t columns_;
+  uint64_t rows_;
+  std::vector<float> row_;
+
+  void WriteHeader_();
+};
+
+/// @brief Gnuplot binary matrix, plotted by
+/// splot "file" binary matrix with pm3d
+/// First row holds number of frequencies and frequencies,
+/// following rows hold time and values.
+class GnuplotBinaryWriter : public ResultWriter {
+ public:
+  GnuplotBinaryWriter();
+  virtual ~GnuplotBinaryWriter();
+
+  virtual bool Open(const std::string& filename,
+                    const std::vector<float>& freqs);
+  virtual void Write(float time, const std::vector<float>& values);
+  virtual bool Close();
+  virtual void Flush();
+
+ private:
+  FILE* fp_;
+  std::vector<float> row_;
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_RESULT_WRITER_HPP_
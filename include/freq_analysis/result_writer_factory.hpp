@@ -0,0 +1,19 @@
+/// @file result_writer_factory.hpp
+/// @brief Creation of ResultWriter by name of format
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_RESULT_WRITER_FACTORY_HPP_
+#define FREQ_ANALYSIS_RESULT_WRITER_FACTORY_HPP_
+
+#include <string>
+
+#include "freq_analysis/result_writer.hpp"
+
+namespace freq_analysis {
+
+ResultWriterPtr CreateResultWriter(const std::string& format);
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_RESULT_WRITER_FACTORY_HPP_
@@ -0,0 +1,104 @@
+/// @file signal_generator.hpp
+/// @brief Reproducible synthetic multi-channel signals for stress tests
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_SIGNAL_GENERATOR_HPP_
+#define FREQ_ANALYSIS_SIGNAL_GENERATOR_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <random>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// @brief Kind of signal component
+enum SignalKind {
+  kSignalTone,
+  kSignalChirp,
+  kSignalGait,
+  kSignalNoise,
+};
+
+/// @brief Component added to one channel
+struct SignalComponent {
+  SignalKind kind;
+  size_t channel;
+  float amplitude;   ///< std dev for noise
+  float freq;        ///< tone, start of chirp, steps per second of gait
+  float freq_end;    ///< end of chirp
+  float period;      ///< sweep time of chirp[s], repeated
+  float phase;       ///< tone [rad]
+  float duty;        ///< gait, fraction of step with impact
+  float variation;   ///< gait, relative std dev of step period and peak
+
+  // gait state, current step
+  double step_start;
+  double step_period;
+  float step_amplitude;
+};
+
+/// @brief Generator of rows of channels sampled at fixed rate,
+/// with timing faults of real sensors: jitter of sample time, dropouts
+/// of consecutive samples, and samples delivered after their successor.
+/// All randomness is drawn from one mt19937, so equal configuration and
+/// seed give equal rows. Rows are generated one by one, so length of
+/// signal is not limited by memory.
+class SignalGenerator {
+ public:
+  SignalGenerator(size_t channels, float rate, uint32_t seed = 1,
+                  double start_time = 0.0);
+
+  void SetOffset(size_t channel, float offset);
+  void AddTone(size_t channel, float amplitude, float freq,
+               float phase = 0.0);
+  void AddChirp(size_t channel, float amplitude, float freq_start,
+                float freq_end, float period);
+  void AddGait(size_t channel, float amplitude, float step_freq,
+               float duty = 0.3, float variation = 0.05);
+  void AddNoise(size_t channel, float stddev);
+  void SetJitter(float jitter);
+  void SetDropout(float probability, size_t max_length);
+  void SetReorder(float probability);
+
+  bool Next(double& time, float* values);
+  void Reset();
+
+  size_t ChannelCount() const;
+  uint64_t RowCount() const;
+  uint64_t DroppedCount() const;
+  uint64_t ReorderedCount() const;
+
+ private:
+  size_t channels_;
+  double rate_;
+  uint32_t seed_;
+  double start_time_;
+  std::vector<float> offset_list_;
+  std::vector<SignalComponent> component_list_;
+  float jitter_;
+  float dropout_probability_;
+  size_t dropout_length_;
+  float reorder_probability_;
+
+  std::mt19937 rng_;
+  uint64_t index_;
+  uint64_t rows_;
+  uint64_t dropped_;
+  uint64_t reordered_;
+  bool has_pending_;
+  double pending_time_;
+  std::vector<float> pending_values_;
+
+  void Sample_(double& time, float* values);
+  double Uniform_();
+  double Normal_();
+};
+
+typedef boost::shared_ptr<SignalGenerator> SignalGeneratorPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_SIGNAL_GENERATOR_HPP_
@@ -0,0 +1,84 @@
+/// @file spectrogram.hpp
+/// @brief Contiguous time x frequency matrix of converter results
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_SPECTROGRAM_HPP_
+#define FREQ_ANALYSIS_SPECTROGRAM_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// @brief Storage order of Spectrogram
+enum SpectrogramLayout {
+  kRowMajor,     ///< values of one time are contiguous
+  kColumnMajor,  ///< values of one frequency are contiguous
+};
+
+/// @brief Strided read-only view into Spectrogram, valid until the
+/// spectrogram grows
+class SpectrogramView {
+ public:
+  SpectrogramView(const float* data, size_t size, size_t stride) :
+      data_(data), size_(size), stride_(stride) {
+  }
+
+  float operator[](size_t i) const {
+    return data_[i * stride_];
+  }
+  size_t size() const {
+    return size_;
+  }
+  void CopyTo(std::vector<float>& result) const;
+
+ private:
+  const float* data_;
+  size_t size_;
+  size_t stride_;
+};
+
+/// @brief Converter results in one contiguous block with selectable
+/// layout, rows are appended with amortized constant cost.
+class Spectrogram {
+ public:
+  explicit Spectrogram(const std::vector<float>& freqs,
+                       SpectrogramLayout layout = kRowMajor);
+
+  void Append(float time, const std::vector<float>& values);
+  void Reserve(size_t rows);
+  void Resize(size_t rows);
+  void SetRow(size_t row, float time, const std::vector<float>& values);
+  void Clear();
+
+  size_t Rows() const;
+  size_t Bands() const;
+  SpectrogramLayout Layout() const;
+  float At(size_t row, size_t band) const;
+  const std::vector<float>& Times() const;
+  const std::vector<float>& Frequencies() const;
+
+  SpectrogramView Row(size_t row) const;
+  SpectrogramView Band(size_t band) const;
+  SpectrogramView Band(size_t band, size_t row_begin, size_t row_end) const;
+  void TimeRange(float start, float end,
+                 size_t& row_begin, size_t& row_end) const;
+
+ private:
+  std::vector<float> freq_list_;
+  std::vector<float> time_list_;
+  std::vector<float> data_;
+  SpectrogramLayout layout_;
+  size_t capacity_;
+
+  void Grow_(size_t rows);
+  size_t Index_(size_t row, size_t band) const;
+};
+
+typedef boost::shared_ptr<Spectrogram> SpectrogramPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_SPECTROGRAM_HPP_
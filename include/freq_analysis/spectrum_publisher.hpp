@@ -0,0 +1,52 @@
+/// @file spectrum_publisher.hpp
+/// @brief Lock-free publication of the latest converter result
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_SPECTRUM_PUBLISHER_HPP_
+#define FREQ_ANALYSIS_SPECTRUM_PUBLISHER_HPP_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+/// @brief Snapshot of a published spectrum
+struct Spectrum {
+  uint64_t sequence;
+  float time;
+  std::vector<float> values;
+  std::vector<float> frequencies;
+};
+
+/// @brief Seqlock holding the latest spectrum of a single writer.
+///
+/// Publish() never waits for readers; Read() retries only while a
+/// Publish() is in progress, so the writer cost does not depend on
+/// the number of reader threads.
+class SpectrumPublisher {
+ public:
+  explicit SpectrumPublisher(const std::vector<float>& frequencies);
+
+  void Publish(float time, const std::vector<float>& values);
+  bool Read(Spectrum& spectrum) const;
+  uint64_t Sequence() const;
+
+ private:
+  std::vector<float> freq_list_;
+  std::atomic<uint64_t> sequence_;
+  std::atomic<float> time_;
+  std::vector<std::atomic<float> > values_;
+
+  SpectrumPublisher(const SpectrumPublisher&);
+  SpectrumPublisher& operator=(const SpectrumPublisher&);
+};
+
+typedef boost::shared_ptr<SpectrumPublisher> SpectrumPublisherPtr;
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_SPECTRUM_PUBLISHER_HPP_
@@ -0,0 +1,90 @@
+/// @file trace.hpp
+/// @brief Scoped trace events written as Chrome trace JSON
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_TRACE_HPP_
+#define FREQ_ANALYSIS_TRACE_HPP_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace freq_analysis {
+
+/// @brief Complete event of one scope
+struct TraceEvent {
+  const char* name;      ///< must outlive Tracer, usually string literal
+  const char* arg_name;  ///< NULL if event has no argument
+  int64_t arg;
+  int64_t begin;         ///< [ns]
+  int64_t end;           ///< [ns]
+};
+
+/// @brief Process-wide recorder of trace events.
+/// Each thread appends to its own fixed-size buffer without locks
+/// (kBufferEvents unless changed by SetBufferEvents), events
+/// are dropped when the buffer is full. Buffers are kept after threads
+/// exit, and Write outputs all of them as Chrome trace JSON, which can be
+/// opened with chrome://tracing or Perfetto UI.
+/// When disabled, an event costs one relaxed load and a branch.
+class Tracer {
+ public:
+  static const size_t kBufferEvents = 1 << 16;
+
+  static void Enable(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  static bool Enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  static void Record(const char* name, const char* arg_name, int64_t arg,
+                     int64_t begin, int64_t end);
+  static void SetThreadName(const std::string& name);
+  static void SetBufferEvents(size_t events);
+  static bool Write(const std::string& filename);
+  static void Clear();
+  static uint64_t EventCount();
+  static uint64_t DroppedCount();
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+/// @brief Records an event from construction to destruction
+/// if tracing was enabled at construction
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name) :
+      name_(name), arg_name_(NULL), arg_(0),
+      begin_(Tracer::Enabled() ? Tracer::Now() : -1) {
+  }
+  TraceScope(const char* name, const char* arg_name, int64_t arg) :
+      name_(name), arg_name_(arg_name), arg_(arg),
+      begin_(Tracer::Enabled() ? Tracer::Now() : -1) {
+  }
+  ~TraceScope() {
+    if (begin_ >= 0) {
+      Tracer::Record(name_, arg_name_, arg_, begin_, Tracer::Now());
+    }
+  }
+
+ private:
+  const char* name_;
+  const char* arg_name_;
+  int64_t arg_;
+  int64_t begin_;
+
+  TraceScope(const TraceScope&);
+  TraceScope& operator=(const TraceScope&);
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_TRACE_HPP_
@@ -6,6 +6,7 @@
 #ifndef FREQ_ANALYSIS_WAVELET_CONVERTER_
 #define FREQ_ANALYSIS_WAVELET_CONVERTER_
 
+#include <stdint.h>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -13,21 +14,58 @@
 #include <boost/shared_ptr.hpp>
 
 #include "freq_analysis/gabor_wavelet.hpp"
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/spectrum_publisher.hpp"
+#include "freq_analysis/call_recorder.hpp"
 
 namespace freq_analysis {
 
+/// @brief Counters and state of WaveletConverter. Counters stay 0 when
+/// built without FREQ_ANALYSIS_ENABLE_STATS.
+struct ConverterStats {
+  uint64_t samples_ingested;
+  uint64_t convert_calls;
+  uint64_t evictions;
+  size_t buffer_occupancy;
+  size_t buffer_capacity;
+  // buffers and per-filter state owned by converter, estimated
+  size_t memory_bytes;
+  // value tables of filters, which may be shared with other converters
+  size_t bank_memory_bytes;
+  std::vector<float> frequencies;
+  // filter evaluations by this converter, pruned filters are not counted
+  std::vector<uint64_t> band_samples_visited;
+  std::vector<uint64_t> band_nanoseconds;
+};
+
 class WaveletConverter {
  public:
   WaveletConverter(float start, float step, size_t length,
                    size_t max_buf_length, float center_t,
                    float sigma = 2.0);
+  WaveletConverter(FilterBankPtr bank, size_t max_buf_length, float center_t);
 
   void AddValue(float time, float value);
   void ClearValue();
   void Convert(std::vector<float>& result);
+  bool ConvertWithin(double budget, std::vector<float>& result,
+                     std::vector<bool>& stale);
+  void SetPriority(const std::vector<size_t>& order);
+  uint64_t DegradedCount() const;
+  void EnablePruning(float threshold, size_t refresh_interval);
+  void DisablePruning();
+  void PruningErrorEstimates(std::vector<float>& result);
+  uint64_t PrunedCount() const;
   void Frequencies(std::vector<float>& result);
+  FilterBankPtr Bank() const;
+  void SetPublisher(SpectrumPublisherPtr publisher);
+  bool SetRecorder(CallRecorderPtr recorder);
+  void Stats(ConverterStats& stats) const;
+  void ResetStats();
+  bool DumpStats(const std::string& filename) const;
 
  private:
+  FilterBankPtr bank_;
   std::vector<GaborFilterPtr> filter_list_;
   std::vector<float> freq_list_;
   std::list<float> time_list_;
@@ -35,6 +73,34 @@ class WaveletConverter {
 
   size_t max_buf_length_;
   float center_t_;
+
+  SpectrumPublisherPtr publisher_;
+  CallRecorderPtr recorder_;
+
+  std::vector<size_t> priority_list_;
+  std::vector<float> last_result_;
+  uint64_t degraded_count_;
+
+  bool pruning_;
+  float prune_threshold_;
+  size_t refresh_interval_;
+  double value_sum_;
+  double value_sq_sum_;
+  std::vector<float> eval_std_list_;
+  std::vector<size_t> age_list_;
+  std::vector<float> error_estimate_list_;
+  std::vector<float> drift_list_;
+  uint64_t pruned_count_;
+
+  uint64_t samples_ingested_;
+  uint64_t convert_calls_;
+  uint64_t evictions_;
+  std::vector<uint64_t> band_visited_list_;
+  std::vector<uint64_t> band_ns_list_;
+
+  float ValueStd_() const;
+  bool Initial_() const;
+  float EvaluateBand_(size_t idx, float time, float value_std);
 };
 
 typedef boost::shared_ptr<WaveletConverter> WaveletConverterPtr;
@@ -0,0 +1,107 @@
+/// @file batch_layout.cpp
+/// @brief Output files of batch processing mirroring tree of input files
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/batch_layout.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace freq_analysis {
+
+/// @brief Constructor
+/// @param output_dir Root of output files
+/// @param suffix Replaces extension of input file, e.g. ".result.dat"
+BatchLayout::BatchLayout(const std::string& output_dir,
+                         const std::string& suffix) :
+    output_dir_(output_dir), suffix_(suffix) {
+}
+
+/// @brief Compute output file for each input file.
+///        Inputs naming the same file are processed once.
+/// @return false if two different inputs map to same output file
+/// @param inputs Input files
+bool BatchLayout::Plan(const std::vector<std::string>& inputs) {
+  input_list_.clear();
+  output_list_.clear();
+  std::vector<std::string> absolute;
+  std::set<std::string> seen;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    std::error_code ec;
+    std::string path = fs::weakly_canonical(fs::absolute(inputs[i]), ec)
+        .string();
+    if (ec) {
+      path = fs::absolute(inputs[i]).lexically_normal().string();
+    }
+    if (!seen.insert(path).second) {
+      std::cerr << "duplicated input: " << inputs[i] << std::endl;
+      continue;
+    }
+    input_list_.push_back(inputs[i]);
+    absolute.push_back(path);
+  }
+
+  root_ = CommonRoot(absolute);
+  std::map<std::string, std::string> output_map;
+  bool ok = true;
+  for (size_t i = 0; i < absolute.size(); i++) {
+    fs::path relative = fs::path(absolute[i]).lexically_relative(root_);
+    relative.replace_extension();
+    std::string output =
+        (fs::path(output_dir_) / relative).string() + suffix_;
+    std::pair<std::map<std::string, std::string>::iterator, bool> inserted =
+        output_map.insert(std::make_pair(output, input_list_[i]));
+    if (!inserted.second) {
+      std::cerr << "output collision: " << input_list_[i] << " and "
+                << inserted.first->second << " -> " << output << std::endl;
+      ok = false;
+    }
+    output_list_.push_back(output);
+  }
+  return ok;
+}
+
+/// @brief Common root directory of last Plan
+const std::string& BatchLayout::Root() const {
+  return root_;
+}
+
+/// @brief Distinct input files of last Plan
+const std::vector<std::string>& BatchLayout::Inputs() const {
+  return input_list_;
+}
+
+/// @brief Output file for each of Inputs()
+const std::vector<std::string>& BatchLayout::Outputs() const {
+  return output_list_;
+}
+
+/// @brief Deepest directory containing all paths
+/// @return Common directory, empty for no paths
+/// @param paths Absolute normalized file paths
+std::string BatchLayout::CommonRoot(const std::vector<std::string>& paths) {
+  if (paths.empty()) {
+    return std::string();
+  }
+  fs::path root = fs::path(paths[0]).parent_path();
+  for (size_t i = 1; i < paths.size(); i++) {
+    fs::path dir = fs::path(paths[i]).parent_path();
+    fs::path common;
+    fs::path::iterator a = root.begin();
+    fs::path::iterator b = dir.begin();
+    for (; a != root.end() && b != dir.end() && *a == *b; ++a, ++b) {
+      common /= *a;
+    }
+    root = common;
+  }
+  return root.string();
+}
+
+}  // namespace
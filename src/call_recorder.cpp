@@ -0,0 +1,368 @@
+/// @file call_recorder.cpp
+/// @brief Binary trace of WaveletConverter calls for replay
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/call_recorder.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <string.h>
+
+namespace freq_analysis {
+
+namespace {
+
+const char kMagic[4] = {'F', 'Q', 'C', 'R'};
+const uint32_t kVersion = 1;
+const size_t kBufferBytes = 1 << 16;
+
+/// @brief Sequential reader of trace in memory
+class ByteReader {
+ public:
+  ByteReader(const std::vector<char>& data, size_t pos) :
+      data_(data), pos_(pos) {
+  }
+
+  bool Read(void* dst, size_t size) {
+    if (pos_ + size > data_.size()) {
+      return false;
+    }
+    memcpy(dst, &data_[pos_], size);
+    pos_ += size;
+    return true;
+  }
+
+  bool AtEnd() const {
+    return pos_ >= data_.size();
+  }
+
+  size_t Remaining() const {
+    return AtEnd() ? 0 : data_.size() - pos_;
+  }
+
+ private:
+  const std::vector<char>& data_;
+  size_t pos_;
+};
+
+}  // namespace
+
+/// @brief Constructor
+CallRecorder::CallRecorder() : fp_(NULL), started_(false) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+/// @brief Destructor, closes file
+CallRecorder::~CallRecorder() {
+  Close();
+}
+
+/// @brief Create trace file, calls are recorded after Start
+/// @return false if file cannot be created
+/// @param filename Trace file
+/// @param record_results Also record results of Convert for comparison
+bool CallRecorder::Open(const std::string& filename, bool record_results) {
+  Close();
+  fp_ = fopen(filename.c_str(), "wb");
+  if (!fp_) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  buffer_.resize(kBufferBytes);
+  setvbuf(fp_, &buffer_[0], _IOFBF, buffer_.size());
+  memset(&header_, 0, sizeof(header_));
+  memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kVersion;
+  header_.flags = record_results ? kCallTraceResults : 0;
+  started_ = false;
+  return true;
+}
+
+/// @brief Write configuration of converter and start recording,
+///        called by WaveletConverter::SetRecorder
+/// @return false if not opened or already started by other converter
+/// @param config Configuration of converter
+bool CallRecorder::Start(const CallTraceConfig& config) {
+  if (!fp_ || started_) {
+    return false;
+  }
+  header_.band_count = config.band_count;
+  header_.start = config.start;
+  header_.step = config.step;
+  header_.sigma = config.sigma;
+  header_.table_resolution = config.table_resolution;
+  header_.max_buf_length = config.max_buf_length;
+  header_.center_t = config.center_t;
+  fwrite(&header_, sizeof(header_), 1, fp_);
+  started_ = true;
+  return true;
+}
+
+/// @brief Write number of records into header and close file
+/// @return false if nothing was open or write failed
+bool CallRecorder::Close() {
+  if (!fp_) {
+    return false;
+  }
+  if (started_) {
+    fseek(fp_, 0, SEEK_SET);
+    fwrite(&header_, sizeof(header_), 1, fp_);
+  }
+  bool ok = started_ && !ferror(fp_);
+  fclose(fp_);
+  fp_ = NULL;
+  started_ = false;
+  return ok;
+}
+
+/// @brief true while recording
+bool CallRecorder::Started() const {
+  return started_;
+}
+
+/// @brief Number of calls recorded
+uint64_t CallRecorder::RecordCount() const {
+  return header_.record_count;
+}
+
+/// @brief Record AddValue
+/// @param time Time stamp
+/// @param value Value
+void CallRecorder::AddValue(float time, float value) {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallAddValue);
+  fwrite(&time, sizeof(time), 1, fp_);
+  fwrite(&value, sizeof(value), 1, fp_);
+}
+
+/// @brief Record ClearValue
+void CallRecorder::ClearValue() {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallClearValue);
+}
+
+/// @brief Record Convert
+/// @param result Result of Convert
+void CallRecorder::Convert(const std::vector<float>& result) {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallConvert);
+  if ((header_.flags & kCallTraceResults) && !result.empty()) {
+    fwrite(&result[0], sizeof(float), result.size(), fp_);
+  }
+}
+
+/// @brief Record ConvertWithin
+/// @param budget Time budget[s]
+/// @param complete Return value of ConvertWithin
+/// @param result Result of ConvertWithin
+void CallRecorder::ConvertWithin(double budget, bool complete,
+                                 const std::vector<float>& result) {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallConvertWithin);
+  uint8_t flag = complete ? 1 : 0;
+  fwrite(&budget, sizeof(budget), 1, fp_);
+  fwrite(&flag, sizeof(flag), 1, fp_);
+  if ((header_.flags & kCallTraceResults) && !result.empty()) {
+    fwrite(&result[0], sizeof(float), result.size(), fp_);
+  }
+}
+
+/// @brief Record EnablePruning
+/// @param threshold Filters predicted below this are pruned
+/// @param refresh_interval Interval of forced evaluation
+void CallRecorder::EnablePruning(float threshold, uint32_t refresh_interval) {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallEnablePruning);
+  fwrite(&threshold, sizeof(threshold), 1, fp_);
+  fwrite(&refresh_interval, sizeof(refresh_interval), 1, fp_);
+}
+
+/// @brief Record DisablePruning
+void CallRecorder::DisablePruning() {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallDisablePruning);
+}
+
+/// @brief Record SetPriority
+/// @param order Indices of filters, highest priority first
+void CallRecorder::SetPriority(const std::vector<size_t>& order) {
+  if (!started_) {
+    return;
+  }
+  WriteType_(kCallSetPriority);
+  uint32_t count = order.size();
+  fwrite(&count, sizeof(count), 1, fp_);
+  for (size_t i = 0; i < order.size(); i++) {
+    uint32_t idx = order[i];
+    fwrite(&idx, sizeof(idx), 1, fp_);
+  }
+}
+
+/// @brief Write type of record and count it
+void CallRecorder::WriteType_(CallType type) {
+  uint8_t byte = type;
+  fwrite(&byte, sizeof(byte), 1, fp_);
+  header_.record_count++;
+}
+
+/// @brief Constructor
+CallTrace::CallTrace() : has_results_(false) {
+  memset(&config_, 0, sizeof(config_));
+}
+
+/// @brief Read whole trace file. Truncated last record, e.g. of recorder
+///        which was not closed, is dropped with warning.
+/// @return false if file cannot be read or is not a trace
+/// @param filename Trace file
+bool CallTrace::Read(const std::string& filename) {
+  record_list_.clear();
+  result_list_.clear();
+  index_list_.clear();
+
+  FILE* fp = fopen(filename.c_str(), "rb");
+  if (!fp) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  std::vector<char> data;
+  char chunk[kBufferBytes];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  fclose(fp);
+
+  CallTraceHeader header;
+  if (data.size() < sizeof(header)) {
+    std::cerr << "not a call trace: " << filename << std::endl;
+    return false;
+  }
+  memcpy(&header, &data[0], sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion) {
+    std::cerr << "not a call trace: " << filename << std::endl;
+    return false;
+  }
+  config_.start = header.start;
+  config_.step = header.step;
+  config_.band_count = header.band_count;
+  config_.sigma = header.sigma;
+  config_.table_resolution = header.table_resolution;
+  config_.max_buf_length = header.max_buf_length;
+  config_.center_t = header.center_t;
+  has_results_ = (header.flags & kCallTraceResults) != 0;
+  // every record has at least its type byte
+  record_list_.reserve(std::min(header.record_count,
+                                static_cast<uint64_t>(data.size())));
+
+  size_t result_size = has_results_ ? header.band_count : 0;
+  ByteReader reader(data, sizeof(header));
+  while (!reader.AtEnd()) {
+    CallRecord record;
+    memset(&record, 0, sizeof(record));
+    uint8_t type;
+    bool ok = reader.Read(&type, sizeof(type));
+    record.type = static_cast<CallType>(type);
+    switch (type) {
+      case kCallAddValue:
+        ok = ok && reader.Read(&record.time, sizeof(record.time)) &&
+            reader.Read(&record.value, sizeof(record.value));
+        break;
+      case kCallConvertWithin: {
+        uint8_t flag = 0;
+        ok = ok && reader.Read(&record.budget, sizeof(record.budget)) &&
+            reader.Read(&flag, sizeof(flag));
+        record.complete = flag != 0;
+      }
+        [[fallthrough]];
+      case kCallConvert:
+        record.offset = result_list_.size();
+        record.count = result_size;
+        // band_count of header is checked before allocating results
+        ok = ok && result_size <= reader.Remaining() / sizeof(float);
+        if (ok && result_size > 0) {
+          result_list_.resize(result_list_.size() + result_size);
+          ok = reader.Read(&result_list_[record.offset],
+                           result_size * sizeof(float));
+        }
+        break;
+      case kCallEnablePruning:
+        ok = ok && reader.Read(&record.value, sizeof(record.value)) &&
+            reader.Read(&record.count, sizeof(record.count));
+        break;
+      case kCallSetPriority:
+        ok = ok && reader.Read(&record.count, sizeof(record.count)) &&
+            record.count <= reader.Remaining() / sizeof(uint32_t);
+        record.offset = index_list_.size();
+        if (ok && record.count > 0) {
+          index_list_.resize(index_list_.size() + record.count);
+          ok = reader.Read(&index_list_[record.offset],
+                           record.count * sizeof(uint32_t));
+        }
+        break;
+      case kCallClearValue:
+      case kCallDisablePruning:
+        break;
+      default:
+        std::cerr << "unknown record type " << static_cast<int>(type)
+                  << " in " << filename << std::endl;
+        return false;
+    }
+    if (!ok) {
+      std::cerr << "truncated record " << record_list_.size()
+                << " in " << filename << std::endl;
+      break;
+    }
+    record_list_.push_back(record);
+  }
+  return true;
+}
+
+/// @brief Configuration of recorded converter
+const CallTraceConfig& CallTrace::Config() const {
+  return config_;
+}
+
+/// @brief true if results of Convert were recorded
+bool CallTrace::HasResults() const {
+  return has_results_;
+}
+
+/// @brief Number of records
+size_t CallTrace::size() const {
+  return record_list_.size();
+}
+
+/// @brief Record of i-th call
+const CallRecord& CallTrace::operator[](size_t i) const {
+  return record_list_[i];
+}
+
+/// @brief Recorded result of Convert or ConvertWithin,
+///        NULL if results were not recorded
+const float* CallTrace::Results(const CallRecord& record) const {
+  return record.count > 0 ? &result_list_[record.offset] : NULL;
+}
+
+/// @brief Indices of SetPriority, NULL if empty
+const uint32_t* CallTrace::Indices(const CallRecord& record) const {
+  return record.count > 0 ? &index_list_[record.offset] : NULL;
+}
+
+}  // namespace
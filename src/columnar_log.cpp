@@ -0,0 +1,345 @@
+/// @file columnar_log.cpp
+/// @brief Binary columnar log with time index
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/columnar_log.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace freq_analysis {
+
+namespace {
+
+const char kMagic[4] = {'F', 'Q', 'C', 'L'};
+// version 2 stores time as offset from double time of block
+const uint32_t kVersion = 2;
+
+}  // namespace
+
+/// @brief Constructor
+ColumnarLogWriter::ColumnarLogWriter() : fp_(NULL), rows_(0) {
+}
+
+/// @brief Destructor, closes file
+ColumnarLogWriter::~ColumnarLogWriter() {
+  Close();
+}
+
+/// @brief Create log file
+/// @return false if file cannot be created
+/// @param filename Log file
+/// @param column_names Names of columns, first column is time
+/// @param block_rows Number of rows in each block
+bool ColumnarLogWriter::Open(const std::string& filename,
+                             const std::vector<std::string>& column_names,
+                             uint32_t block_rows) {
+  Close();
+  if (column_names.empty() || block_rows == 0) {
+    return false;
+  }
+  fp_ = fopen(filename.c_str(), "wb");
+  if (!fp_) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+
+  memset(&header_, 0, sizeof(header_));
+  memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kVersion;
+  header_.column_count = column_names.size();
+  header_.block_rows = block_rows;
+  fwrite(&header_, sizeof(header_), 1, fp_);
+  for (size_t i = 0; i < column_names.size(); i++) {
+    char name[kNameLength];
+    memset(name, 0, sizeof(name));
+    strncpy(name, column_names[i].c_str(), kNameLength - 1);
+    fwrite(name, sizeof(name), 1, fp_);
+  }
+
+  block_.resize(static_cast<size_t>(block_rows) * column_names.size());
+  time_list_.resize(block_rows);
+  rows_ = 0;
+  index_list_.clear();
+  return true;
+}
+
+/// @brief Add row
+/// @param row Array of values for each columns, time first
+void ColumnarLogWriter::Write(const float* row) {
+  Write(row[0], row + 1);
+}
+
+/// @brief Add row with time in double precision
+/// @param time Time, first column
+/// @param values Array of values for each following columns
+void ColumnarLogWriter::Write(double time, const float* values) {
+  if (!fp_) {
+    return;
+  }
+  time_list_[rows_] = time;
+  for (size_t c = 1; c < header_.column_count; c++) {
+    block_[c * header_.block_rows + rows_] = values[c - 1];
+  }
+  rows_++;
+  header_.row_count++;
+  if (rows_ == header_.block_rows) {
+    FlushBlock_();
+  }
+}
+
+/// @brief Write remaining rows and index, then close file
+/// @return false if nothing was open or write failed
+bool ColumnarLogWriter::Close() {
+  if (!fp_) {
+    return false;
+  }
+  FlushBlock_();
+  header_.block_count = index_list_.size();
+  // align index for its 64bit members
+  long pos = ftell(fp_);
+  while (pos % 8 != 0) {
+    fputc(0, fp_);
+    pos++;
+  }
+  header_.index_offset = pos;
+  if (!index_list_.empty()) {
+    fwrite(&index_list_[0], sizeof(ColumnarLogIndex), index_list_.size(),
+           fp_);
+  }
+  fseek(fp_, 0, SEEK_SET);
+  fwrite(&header_, sizeof(header_), 1, fp_);
+  bool ok = !ferror(fp_);
+  fclose(fp_);
+  fp_ = NULL;
+  return ok;
+}
+
+/// @brief Write buffered rows as block
+void ColumnarLogWriter::FlushBlock_() {
+  if (rows_ == 0) {
+    return;
+  }
+  ColumnarLogIndex index;
+  index.first_time = time_list_[0];
+  index.last_time = time_list_[rows_ - 1];
+  for (size_t i = 0; i < rows_; i++) {
+    block_[i] = static_cast<float>(time_list_[i] - index.first_time);
+  }
+  index.rows = rows_;
+  index.reserved = 0;
+  index.offset = ftell(fp_);
+  for (size_t c = 0; c < header_.column_count; c++) {
+    fwrite(&block_[c * header_.block_rows], sizeof(float), rows_, fp_);
+  }
+  index_list_.push_back(index);
+  rows_ = 0;
+}
+
+/// @brief Constructor
+ColumnarLogReader::ColumnarLogReader() :
+    addr_(NULL), length_(0), header_(NULL), index_(NULL) {
+}
+
+/// @brief Destructor, unmaps file
+ColumnarLogReader::~ColumnarLogReader() {
+  Close();
+}
+
+/// @brief Map log file, header and every index entry are checked against
+///        file size, so Read never touches bytes outside of file
+/// @return false if file is missing or not a columnar log
+/// @param filename Log file
+bool ColumnarLogReader::Open(const std::string& filename) {
+  Close();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(ColumnarLogHeader)) {
+    close(fd);
+    return false;
+  }
+  length_ = static_cast<size_t>(st.st_size);
+  void* addr = mmap(NULL, length_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    length_ = 0;
+    return false;
+  }
+  addr_ = static_cast<const char*>(addr);
+  header_ = reinterpret_cast<const ColumnarLogHeader*>(addr_);
+
+  uint64_t names_end = sizeof(ColumnarLogHeader) +
+      static_cast<uint64_t>(header_->column_count) *
+      ColumnarLogWriter::kNameLength;
+  // each check keeps following products and sums within length
+  bool valid =
+      memcmp(header_->magic, kMagic, sizeof(kMagic)) == 0 &&
+      header_->version == kVersion && names_end <= length_ &&
+      header_->index_offset <= length_ &&
+      header_->block_count <=
+      (length_ - header_->index_offset) / sizeof(ColumnarLogIndex);
+  if (valid) {
+    const ColumnarLogIndex* index = reinterpret_cast<const ColumnarLogIndex*>(
+        addr_ + header_->index_offset);
+    uint64_t rows = 0;
+    for (uint64_t b = 0; valid && b < header_->block_count; b++) {
+      valid = index[b].rows <= header_->block_rows &&
+          index[b].offset >= names_end && index[b].offset <= length_ &&
+          static_cast<uint64_t>(header_->column_count) * index[b].rows <=
+          (length_ - index[b].offset) / sizeof(float);
+      rows += index[b].rows;
+    }
+    valid = valid && rows == header_->row_count;
+  }
+  if (!valid) {
+    std::cerr << "invalid columnar log: " << filename << std::endl;
+    Close();
+    return false;
+  }
+
+  const char* name = addr_ + sizeof(ColumnarLogHeader);
+  for (size_t i = 0; i < header_->column_count; i++) {
+    name_list_.push_back(
+        std::string(name, strnlen(name, ColumnarLogWriter::kNameLength)));
+    name += ColumnarLogWriter::kNameLength;
+  }
+  index_ = reinterpret_cast<const ColumnarLogIndex*>(
+      addr_ + header_->index_offset);
+  return true;
+}
+
+/// @brief Unmap file
+void ColumnarLogReader::Close() {
+  if (addr_) {
+    munmap(const_cast<char*>(addr_), length_);
+  }
+  addr_ = NULL;
+  length_ = 0;
+  header_ = NULL;
+  index_ = NULL;
+  name_list_.clear();
+}
+
+/// @brief Number of columns
+size_t ColumnarLogReader::ColumnCount() const {
+  return name_list_.size();
+}
+
+/// @brief Number of rows
+uint64_t ColumnarLogReader::RowCount() const {
+  return header_ ? header_->row_count : 0;
+}
+
+/// @brief Find column by name
+/// @return Index of column, -1 if not found
+/// @param name Column name
+int ColumnarLogReader::ColumnIndex(const std::string& name) const {
+  for (size_t i = 0; i < name_list_.size(); i++) {
+    if (name_list_[i] == name) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+/// @brief Getter of column names
+const std::vector<std::string>& ColumnarLogReader::ColumnNames() const {
+  return name_list_;
+}
+
+/// @brief Read rows in time range, only touching blocks in range
+/// @return Number of rows read
+/// @param start Start time, inclusive
+/// @param end End time, inclusive, negative for end of log
+/// @param columns Indices of columns to read, time (0) is read as float
+/// @param result Values for each requested columns
+/// @param rows_after Number of rows after end also read, e.g. 1 for the
+///        first sample past end, which loops over text data process last
+/// @param times Time of rows in double precision if not NULL
+uint64_t ColumnarLogReader::Read(double start, double end,
+                                 const std::vector<size_t>& columns,
+                                 std::vector<std::vector<float> >& result,
+                                 size_t rows_after,
+                                 std::vector<double>* times) const {
+  result.assign(columns.size(), std::vector<float>());
+  if (times) {
+    times->clear();
+  }
+  if (!header_) {
+    return 0;
+  }
+  for (size_t c = 0; c < columns.size(); c++) {
+    if (columns[c] >= header_->column_count) {
+      return 0;
+    }
+  }
+  bool to_end = end < 0.0;
+
+  // first block which may contain start
+  size_t lower = 0;
+  size_t upper = header_->block_count;
+  while (lower < upper) {
+    size_t mid = (lower + upper) / 2;
+    if (index_[mid].last_time < start) {
+      lower = mid + 1;
+    } else {
+      upper = mid;
+    }
+  }
+
+  uint64_t count = 0;
+  for (size_t b = lower; b < header_->block_count; b++) {
+    const ColumnarLogIndex& index = index_[b];
+    if (!to_end && index.first_time > end && rows_after == 0) {
+      break;
+    }
+    const float* block = reinterpret_cast<const float*>(addr_ + index.offset);
+    const float* offset = block;
+    size_t first = 0;
+    while (first < index.rows && index.first_time + offset[first] < start) {
+      first++;
+    }
+    size_t last = index.rows;
+    if (!to_end) {
+      while (last > first && index.first_time + offset[last - 1] > end) {
+        last--;
+      }
+      size_t after = std::min(rows_after, index.rows - last);
+      last += after;
+      rows_after -= after;
+    }
+    for (size_t c = 0; c < columns.size(); c++) {
+      if (columns[c] == 0) {
+        for (size_t i = first; i < last; i++) {
+          result[c].push_back(index.first_time + offset[i]);
+        }
+        continue;
+      }
+      const float* column = block + columns[c] * index.rows;
+      result[c].insert(result[c].end(), column + first, column + last);
+    }
+    if (times) {
+      for (size_t i = first; i < last; i++) {
+        times->push_back(index.first_time + offset[i]);
+      }
+    }
+    count += last - first;
+  }
+  return count;
+}
+
+}  // namespace
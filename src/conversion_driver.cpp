@@ -0,0 +1,166 @@
+/// @file conversion_driver.cpp
+/// @brief Periodic background conversion with WaveletConverter
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/conversion_driver.hpp"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+namespace freq_analysis {
+
+namespace {
+
+const int64_t kNanoPerSec = 1000000000LL;
+
+// longest period whose nanoseconds fit in int64_t with room for deadlines
+const double kMaxPeriod = 1.0e9;
+
+int64_t MonotonicNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+/// @brief Constructor
+/// @param converter Converter driven by this instance
+/// @param rate Output rate [Hz], Start fails unless positive
+ConversionDriver::ConversionDriver(WaveletConverterPtr converter, float rate) :
+    converter_(converter), period_(1.0 / rate),
+    latest_time_(0.0), has_value_(false), running_(false), jitter_sum_(0.0) {
+  if (!(period_ > 0.0 && period_ <= kMaxPeriod)) {
+    std::cerr << "invalid output rate: " << rate << std::endl;
+    period_ = 0.0;
+  }
+  stats_.ticks = 0;
+  stats_.conversions = 0;
+  stats_.missed_deadlines = 0;
+  stats_.mean_jitter = 0.0;
+  stats_.max_jitter = 0.0;
+}
+
+/// @brief Destructor, stops thread
+ConversionDriver::~ConversionDriver() {
+  Stop();
+}
+
+/// @brief Register callback called from driver thread for each result
+/// @param callback Callback
+void ConversionDriver::AddCallback(const Callback& callback) {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  callback_list_.push_back(callback);
+}
+
+/// @brief Add value with time stamp, safe to call while running
+/// @param time Time stamp
+/// @param value Value
+void ConversionDriver::AddValue(float time, float value) {
+  std::lock_guard<std::mutex> lock(converter_mutex_);
+  converter_->AddValue(time, value);
+  latest_time_ = time;
+  has_value_ = true;
+}
+
+/// @brief Start driver thread
+/// @return false if already running or rate is invalid
+bool ConversionDriver::Start() {
+  if (period_ <= 0.0 || running_.exchange(true)) {
+    return false;
+  }
+  thread_ = std::thread(&ConversionDriver::Run_, this);
+  return true;
+}
+
+/// @brief Stop driver thread and wait for it, must not be called
+///        from a callback
+void ConversionDriver::Stop() {
+  {
+    // flag is cleared under lock, so sleeping thread cannot miss it
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    if (!running_.exchange(false)) {
+      return;
+    }
+  }
+  wake_cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+/// @brief Getter of timing statistics
+DriverStats ConversionDriver::Stats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+/// @brief Thread body, sleeps until absolute deadlines or Stop
+void ConversionDriver::Run_() {
+  int64_t period_ns = static_cast<int64_t>(period_ * kNanoPerSec);
+  int64_t deadline = MonotonicNow() + period_ns;
+  std::vector<float> result;
+  std::vector<Callback> callbacks;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      std::chrono::steady_clock::time_point until =
+          std::chrono::steady_clock::time_point() +
+          std::chrono::nanoseconds(deadline);
+      wake_cond_.wait_until(lock, until, [this] {
+          return !running_.load();
+        });
+    }
+    if (!running_.load()) {
+      break;
+    }
+    int64_t wakeup = MonotonicNow();
+
+    bool converted = false;
+    float time = 0.0;
+    {
+      std::lock_guard<std::mutex> lock(converter_mutex_);
+      if (has_value_) {
+        converter_->Convert(result);
+        time = latest_time_;
+        converted = true;
+      }
+    }
+    if (converted) {
+      // callbacks are called without lock, so they may add callbacks
+      {
+        std::lock_guard<std::mutex> lock(callback_mutex_);
+        callbacks = callback_list_;
+      }
+      for (size_t i = 0; i < callbacks.size(); i++) {
+        callbacks[i](time, result);
+      }
+    }
+
+    double jitter = static_cast<double>(wakeup - deadline) / kNanoPerSec;
+    // skip deadlines already passed instead of bursting to catch up
+    int64_t done = MonotonicNow();
+    uint64_t missed = 0;
+    deadline += period_ns;
+    while (deadline <= done) {
+      deadline += period_ns;
+      missed++;
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.ticks++;
+    if (converted) {
+      stats_.conversions++;
+    }
+    stats_.missed_deadlines += missed;
+    jitter_sum_ += jitter;
+    stats_.mean_jitter = jitter_sum_ / static_cast<double>(stats_.ticks);
+    if (jitter > stats_.max_jitter) {
+      stats_.max_jitter = jitter;
+    }
+  }
+}
+
+}  // namespace
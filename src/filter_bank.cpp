@@ -0,0 +1,69 @@
+/// @file filter_bank.cpp
+/// @brief Immutable set of gabor filters shared by converters
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/filter_bank.hpp"
+
+#include <vector>
+
+namespace freq_analysis {
+
+/// @brief Constructor
+/// @param start Initial frequency
+/// @param step Ratio of geometric series of frequencies
+/// @param length Number of frequencies
+/// @param sigma Sigma of GaborFilter
+/// @param table_resolution Points of value table per period of each filter
+FilterBank::FilterBank(float start, float step, size_t length, float sigma,
+                       float table_resolution) :
+    start_(start), step_(step), sigma_(sigma),
+    table_resolution_(table_resolution) {
+  filter_list_.reserve(length);
+  freq_list_.reserve(length);
+  float freq = start;
+  for (size_t i = 0; i < length; i++) {
+    float time_step = 1.0 / freq / table_resolution;
+    GaborFilterPtr gabor(new GaborFilter(freq, sigma, time_step));
+    filter_list_.push_back(gabor);
+    freq_list_.push_back(freq);
+    freq *= step;
+  }
+}
+
+/// @brief Getter of filters
+const std::vector<GaborFilterPtr>& FilterBank::Filters() const {
+  return filter_list_;
+}
+
+/// @brief Getter of frequencies for each filters
+const std::vector<float>& FilterBank::Frequencies() const {
+  return freq_list_;
+}
+
+/// @brief Number of filters
+size_t FilterBank::size() const {
+  return filter_list_.size();
+}
+
+/// @brief Getter of frequency of first filter
+float FilterBank::Start() const {
+  return start_;
+}
+
+/// @brief Getter of ratio of frequencies of adjacent filters
+float FilterBank::Step() const {
+  return step_;
+}
+
+/// @brief Getter of sigma of filters
+float FilterBank::Sigma() const {
+  return sigma_;
+}
+
+/// @brief Getter of points of value table per period
+float FilterBank::TableResolution() const {
+  return table_resolution_;
+}
+
+}  // namespace
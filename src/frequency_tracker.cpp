@@ -0,0 +1,189 @@
+/// @file frequency_tracker.cpp
+/// @brief Dominant frequency tracking by coarse-to-fine Gabor filtering
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/frequency_tracker.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+
+namespace freq_analysis {
+
+namespace {
+
+// Table points per period. WaveletConverter uses 8, which makes the
+// response ripple by about 1% between neighbouring frequencies and
+// shifts the peak by more than the tracking resolution.
+const float kTableResolution = 32.0;
+
+}  // namespace
+
+/// @brief Constructor
+/// @param min_freq Lowest frequency of coarse grid
+/// @param max_freq Highest frequency of coarse grid
+/// @param coarse_length Number of frequencies in coarse grid >= 2
+/// @param resolution Required resolution of result [Hz]
+/// @param sigma Sigma of GaborFilter
+/// @param cache_size Number of refinement filters kept for reuse
+FrequencyTracker::FrequencyTracker(float min_freq, float max_freq,
+                                   size_t coarse_length, float resolution,
+                                   float sigma, size_t cache_size) :
+    min_freq_(min_freq), max_freq_(max_freq), resolution_(resolution),
+    sigma_(sigma), cache_size_(cache_size) {
+  if (coarse_length < 2) {
+    coarse_length = 2;
+  }
+  float step = pow(max_freq / min_freq, 1.0 / (coarse_length - 1));
+  float freq = min_freq;
+  for (size_t i = 0; i < coarse_length; i++) {
+    float time_step = 1.0 / freq / kTableResolution;
+    GaborFilterPtr gabor(new GaborFilter(freq, sigma, time_step));
+    filter_list_.push_back(gabor);
+    freq_list_.push_back(freq);
+    freq *= step;
+  }
+}
+
+/// @brief Find dominant frequency of time-seriesed values
+/// @return Frequency, magnitude, confidence in [0, 1] as share of
+///         coarse grid energy at peak, and number of evaluated filters
+/// @param time_list Time at for each values
+/// @param value_list Values
+/// @param time_offset Center of Gabor wavelet, see GaborFilter::Filter
+TrackResult FrequencyTracker::Track(const std::list<float>& time_list,
+                                    const std::list<float>& value_list,
+                                    float time_offset) {
+  TrackResult result;
+  result.evaluated = 0;
+
+  // GaborFilter::Filter scales as 1/sqrt(freq) for a tone at its own
+  // frequency, so the search compares value * sqrt(freq) to avoid bias
+  // toward lower frequencies
+  // coarse search
+  size_t peak = 0;
+  float peak_value = -1.0;
+  float energy = 0.0;
+  for (size_t i = 0; i < filter_list_.size(); i++) {
+    float value = filter_list_[i]->Filter(time_list, value_list, time_offset)
+        * sqrt(freq_list_[i]);
+    energy += value * value;
+    if (value > peak_value) {
+      peak_value = value;
+      peak = i;
+    }
+  }
+  result.evaluated += filter_list_.size();
+  result.confidence = energy > 0.0 ? peak_value * peak_value / energy : 0.0;
+
+  // refine around peak, filters are quantized on quarter of resolution
+  float quantum = resolution_ / 4.0;
+  size_t lower = peak > 0 ? peak - 1 : peak;
+  size_t upper = peak + 1 < freq_list_.size() ? peak + 1 : peak;
+  float width = std::min(freq_list_[peak] - freq_list_[lower],
+                         freq_list_[upper] - freq_list_[peak]);
+  if (width <= 0.0) {
+    width = std::max(freq_list_[peak] - freq_list_[lower],
+                     freq_list_[upper] - freq_list_[peak]);
+  }
+  float step = width / 2.0;
+  int64_t center = llround(freq_list_[peak] / quantum);
+  float center_value = peak_value;
+  // key 0 is frequency 0, which has no filter
+  int64_t min_key = std::max<int64_t>(llround(min_freq_ / quantum), 1);
+  int64_t max_key = std::max<int64_t>(llround(max_freq_ / quantum), min_key);
+  center = std::min(std::max(center, min_key), max_key);
+  float left_value = center_value;
+  float right_value = center_value;
+  int64_t offset = 0;
+  bool clamped = false;
+
+  while (true) {
+    offset = llround(step / quantum);
+    if (offset < 1) {
+      offset = 1;
+    }
+    int64_t left = std::max(center - offset, min_key);
+    int64_t right = std::min(center + offset, max_key);
+    left_value = left < center ?
+        CachedFilter_(left)->Filter(time_list, value_list, time_offset)
+        * sqrt(left * quantum) :
+        center_value;
+    right_value = right > center ?
+        CachedFilter_(right)->Filter(time_list, value_list, time_offset)
+        * sqrt(right * quantum) :
+        center_value;
+    result.evaluated += (left < center) + (right > center);
+    clamped = center - left != offset || right - center != offset;
+
+    if (left_value > center_value && left_value >= right_value) {
+      center = left;
+      center_value = left_value;
+    } else if (right_value > center_value) {
+      center = right;
+      center_value = right_value;
+    } else if (step > resolution_ / 2.0) {
+      step /= 2.0;
+    } else {
+      break;
+    }
+  }
+
+  // parabolic interpolation on last three points, which needs equal
+  // spacing, so center is kept at edges of the range
+  float frequency = center * quantum;
+  float denom = left_value - 2.0 * center_value + right_value;
+  if (!clamped && denom < 0.0) {
+    float delta = 0.5 * (left_value - right_value) / denom;
+    if (delta > 0.5) {
+      delta = 0.5;
+    } else if (delta < -0.5) {
+      delta = -0.5;
+    }
+    frequency += delta * offset * quantum;
+    center_value -= 0.25 * (left_value - right_value) * delta;
+  }
+
+  result.frequency = frequency;
+  result.magnitude = center_value / sqrt(frequency);
+  return result;
+}
+
+/// @brief Getter of frequencies of coarse grid
+/// @param result Frequencies
+void FrequencyTracker::Frequencies(std::vector<float>& result) {
+  result.assign(freq_list_.begin(), freq_list_.end());
+}
+
+/// @brief Number of refinement filters in cache
+size_t FrequencyTracker::CachedFilters() const {
+  return cache_list_.size();
+}
+
+/// @brief Get refinement filter from cache, or create it
+/// @param key Frequency in unit of quarter of resolution
+GaborFilterPtr FrequencyTracker::CachedFilter_(int64_t key) {
+  std::map<int64_t, std::list<CacheEntry>::iterator>::iterator found =
+      cache_map_.find(key);
+  if (found != cache_map_.end()) {
+    // move to front as most recently used
+    cache_list_.splice(cache_list_.begin(), cache_list_, found->second);
+    return found->second->second;
+  }
+
+  float freq = key * resolution_ / 4.0;
+  float time_step = 1.0 / freq / kTableResolution;
+  GaborFilterPtr gabor(new GaborFilter(freq, sigma_, time_step));
+  cache_list_.push_front(CacheEntry(key, gabor));
+  cache_map_[key] = cache_list_.begin();
+  if (cache_list_.size() > cache_size_) {
+    cache_map_.erase(cache_list_.back().first);
+    cache_list_.pop_back();
+  }
+  return gabor;
+}
+
+}  // namespace
@@ -78,7 +78,7 @@ void GaborFilter::InitTable_() {
 /// @brief Approximate value of Gabor wavelet
 /// @return Complex number as std::pair
 /// @param time Time[s]
-std::pair<float, float> GaborFilter::ApproxValue(float time) {
+std::pair<float, float> GaborFilter::ApproxValue(float time) const {
   int32_t idx = static_cast<int32_t>(time / time_step_
                                      + static_cast<float>(table_size_));
   float a = (time / time_step_ + static_cast<float>(table_size_))
@@ -102,9 +102,9 @@ std::pair<float, float> GaborFilter::ApproxValue(float time) {
 /// @param time_list Time at for each values
 /// @param value_list Values
 /// @param time_offset Time offset[s] > 0.0, center of Gabor wavelet = -time_offset
-float GaborFilter::Filter(const std::list<float> time_list,
-                          const std::list<float> value_list,
-                          float time_offset) {
+float GaborFilter::Filter(const std::list<float>& time_list,
+                          const std::list<float>& value_list,
+                          float time_offset) const {
   std::list<float>::const_iterator time_iter = time_list.begin();
   std::list<float>::const_iterator value_iter = value_list.begin();
 
@@ -145,5 +145,11 @@ void GaborFilter::Status() {
   std::cout << "gabor_table_i_.size(): " << gabor_table_i_.size() << std::endl;
 }
 
+/// @brief Bytes held by filter including value tables
+size_t GaborFilter::MemoryBytes() const {
+  return sizeof(*this) + sizeof(float) *
+      (gabor_table_r_.capacity() + gabor_table_i_.capacity());
+}
+
 
 }  // namespace
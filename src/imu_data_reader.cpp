@@ -0,0 +1,231 @@
+/// @file imu_data_reader.cpp
+/// @brief Parallel reader of imu data files
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/imu_data_reader.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <charconv>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace freq_analysis {
+
+/// @brief Number of rows
+size_t ImuColumns::size() const {
+  return time.size();
+}
+
+/// @brief Remove all rows
+void ImuColumns::clear() {
+  time.clear();
+  acc_x.clear();
+  acc_y.clear();
+  acc_z.clear();
+  gyro_x.clear();
+  gyro_y.clear();
+  gyro_z.clear();
+}
+
+/// @brief Reserve rows for each columns
+/// @param length Number of rows
+void ImuColumns::reserve(size_t length) {
+  time.reserve(length);
+  acc_x.reserve(length);
+  acc_y.reserve(length);
+  acc_z.reserve(length);
+  gyro_x.reserve(length);
+  gyro_y.reserve(length);
+  gyro_z.reserve(length);
+}
+
+/// @brief Add row
+/// @param fields Array of ImuDataReader::kFields values
+void ImuColumns::push_back(const float* fields) {
+  time.push_back(fields[0]);
+  acc_x.push_back(fields[1]);
+  acc_y.push_back(fields[2]);
+  acc_z.push_back(fields[3]);
+  gyro_x.push_back(fields[4]);
+  gyro_y.push_back(fields[5]);
+  gyro_z.push_back(fields[6]);
+}
+
+/// @brief Add all rows of other columns
+/// @param obj Rows to add
+void ImuColumns::append(const ImuColumns& obj) {
+  time.insert(time.end(), obj.time.begin(), obj.time.end());
+  acc_x.insert(acc_x.end(), obj.acc_x.begin(), obj.acc_x.end());
+  acc_y.insert(acc_y.end(), obj.acc_y.begin(), obj.acc_y.end());
+  acc_z.insert(acc_z.end(), obj.acc_z.begin(), obj.acc_z.end());
+  gyro_x.insert(gyro_x.end(), obj.gyro_x.begin(), obj.gyro_x.end());
+  gyro_y.insert(gyro_y.end(), obj.gyro_y.begin(), obj.gyro_y.end());
+  gyro_z.insert(gyro_z.end(), obj.gyro_z.begin(), obj.gyro_z.end());
+}
+
+/// @brief Constructor
+/// @param threads Number of parser threads, 0 for number of cores
+ImuDataReader::ImuDataReader(size_t threads) :
+    threads_(threads), bytes_read_(0) {
+  if (threads_ == 0) {
+    threads_ = std::thread::hardware_concurrency();
+  }
+  if (threads_ == 0) {
+    threads_ = 1;
+  }
+}
+
+/// @brief Read data file
+/// @return false if file cannot be read
+/// @param filename Data file
+/// @param data Read rows, previous contents are removed
+bool ImuDataReader::Read(const std::string& filename, ImuColumns& data) {
+  data.clear();
+  bytes_read_ = 0;
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  size_t length = static_cast<size_t>(st.st_size);
+  if (length == 0) {
+    close(fd);
+    return true;
+  }
+  void* addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    std::cerr << "cannot map file: " << filename << std::endl;
+    return false;
+  }
+  madvise(addr, length, MADV_SEQUENTIAL);
+  const char* begin = static_cast<const char*>(addr);
+  const char* end = begin + length;
+
+  // split at line boundaries, small files are parsed by one thread
+  size_t chunks = threads_;
+  const size_t kMinChunk = 1 << 20;
+  if (length / kMinChunk + 1 < chunks) {
+    chunks = length / kMinChunk + 1;
+  }
+  std::vector<const char*> bounds(chunks + 1, end);
+  bounds[0] = begin;
+  for (size_t i = 1; i < chunks; i++) {
+    const char* p = begin + length / chunks * i;
+    if (p < bounds[i - 1]) {
+      p = bounds[i - 1];
+    }
+    const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    bounds[i] = nl ? nl + 1 : end;
+  }
+
+  std::vector<ImuColumns> parts(chunks);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < chunks; i++) {
+    workers.push_back(std::thread(&ImuDataReader::ParseChunk,
+                                  bounds[i], bounds[i + 1],
+                                  std::ref(parts[i])));
+  }
+  ParseChunk(bounds[0], bounds[1], parts[0]);
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+  munmap(addr, length);
+
+  if (chunks == 1) {
+    data.time.swap(parts[0].time);
+    data.acc_x.swap(parts[0].acc_x);
+    data.acc_y.swap(parts[0].acc_y);
+    data.acc_z.swap(parts[0].acc_z);
+    data.gyro_x.swap(parts[0].gyro_x);
+    data.gyro_y.swap(parts[0].gyro_y);
+    data.gyro_z.swap(parts[0].gyro_z);
+  } else {
+    size_t rows = 0;
+    for (size_t i = 0; i < parts.size(); i++) {
+      rows += parts[i].size();
+    }
+    data.reserve(rows);
+    for (size_t i = 0; i < parts.size(); i++) {
+      data.append(parts[i]);
+    }
+  }
+  bytes_read_ = length;
+  return true;
+}
+
+/// @brief Size of last read file[byte]
+uint64_t ImuDataReader::BytesRead() const {
+  return bytes_read_;
+}
+
+/// @brief Parse single line
+/// @return false for comment or invalid line
+/// @param begin Start of line
+/// @param end End of line, excluding newline
+/// @param fields Array of kFields values
+bool ImuDataReader::ParseLine(const char* begin, const char* end,
+                              float* fields) {
+  if (begin == end || *begin == '#') {
+    return false;
+  }
+  size_t count = 0;
+  const char* p = begin;
+  while (p < end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+      p++;
+    }
+    if (p == end) {
+      break;
+    }
+    if (count == kFields) {
+      return false;
+    }
+    std::from_chars_result res = std::from_chars(p, end, fields[count]);
+    if (res.ec != std::errc()) {
+      return false;
+    }
+    p = res.ptr;
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+      return false;
+    }
+    count++;
+  }
+  return count == kFields;
+}
+
+/// @brief Parse all lines in buffer
+/// @param begin Start of buffer, at start of line
+/// @param end End of buffer
+/// @param data Parsed rows are added
+void ImuDataReader::ParseChunk(const char* begin, const char* end,
+                               ImuColumns& data) {
+  // rough estimate of 60 bytes per line
+  data.reserve(data.size() + (end - begin) / 60 + 1);
+  float fields[kFields];
+  const char* p = begin;
+  while (p < end) {
+    const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    const char* line_end = nl ? nl : end;
+    if (ParseLine(p, line_end, fields)) {
+      data.push_back(fields);
+    }
+    p = line_end + 1;
+  }
+}
+
+}  // namespace
@@ -0,0 +1,182 @@
+/// @file imu_preprocessor.cpp
+/// @brief Derived signals of imu data computed block by block
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/imu_preprocessor.hpp"
+
+#include <vector>
+
+#include <math.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace freq_analysis {
+
+/// @brief Constructor
+/// @param channels Channels in order of result
+/// @param gravity_time_constant Time constant of gravity low-pass filter[s]
+ImuPreprocessor::ImuPreprocessor(const std::vector<DerivedChannel>& channels,
+                                 float gravity_time_constant) :
+    channel_list_(channels), time_constant_(gravity_time_constant),
+    has_gravity_(false), last_time_(0.0) {
+  gravity_[0] = gravity_[1] = gravity_[2] = 0.0;
+}
+
+/// @brief Compute all channels for rows in [begin, end).
+///        Gravity estimate continues from previous call.
+/// @param data Imu data
+/// @param begin First row
+/// @param end End of rows
+/// @param result Values for each channels, resized to end - begin
+void ImuPreprocessor::Process(const ImuColumns& data, size_t begin,
+                              size_t end,
+                              std::vector<std::vector<float> >& result) {
+  if (end > data.size()) {
+    end = data.size();
+  }
+  size_t length = end > begin ? end - begin : 0;
+  result.resize(channel_list_.size());
+  for (size_t c = 0; c < channel_list_.size(); c++) {
+    std::vector<float>& out = result[c];
+    out.resize(length);
+    if (length == 0) {
+      continue;
+    }
+    switch (channel_list_[c]) {
+      case kAccNorm:
+        Norm(&data.acc_x[begin], &data.acc_y[begin], &data.acc_z[begin],
+             &out[0], length);
+        break;
+      case kGyroNorm:
+        Norm(&data.gyro_x[begin], &data.gyro_y[begin], &data.gyro_z[begin],
+             &out[0], length);
+        break;
+      case kAccX:
+        out.assign(data.acc_x.begin() + begin, data.acc_x.begin() + end);
+        break;
+      case kAccY:
+        out.assign(data.acc_y.begin() + begin, data.acc_y.begin() + end);
+        break;
+      case kAccZ:
+        out.assign(data.acc_z.begin() + begin, data.acc_z.begin() + end);
+        break;
+      case kGyroX:
+        out.assign(data.gyro_x.begin() + begin, data.gyro_x.begin() + end);
+        break;
+      case kGyroY:
+        out.assign(data.gyro_y.begin() + begin, data.gyro_y.begin() + end);
+        break;
+      case kGyroZ:
+        out.assign(data.gyro_z.begin() + begin, data.gyro_z.begin() + end);
+        break;
+      case kAccGravity:
+        EstimateGravity_(data, begin, end);
+        Dot(&data.acc_x[begin], &data.acc_y[begin], &data.acc_z[begin],
+            &unit_x_[0], &unit_y_[0], &unit_z_[0], &out[0], length);
+        break;
+    }
+  }
+}
+
+/// @brief Number of channels
+size_t ImuPreprocessor::ChannelCount() const {
+  return channel_list_.size();
+}
+
+/// @brief Forget gravity estimate
+void ImuPreprocessor::Reset() {
+  has_gravity_ = false;
+  gravity_[0] = gravity_[1] = gravity_[2] = 0.0;
+}
+
+/// @brief Euclidean norm of 3D vectors
+/// @param x X elements
+/// @param y Y elements
+/// @param z Z elements
+/// @param result Norms
+/// @param length Number of vectors
+void ImuPreprocessor::Norm(const float* x, const float* y, const float* z,
+                           float* result, size_t length) {
+  size_t i = 0;
+#ifdef __SSE__
+  for (; i + 4 <= length; i += 4) {
+    __m128 vx = _mm_loadu_ps(x + i);
+    __m128 vy = _mm_loadu_ps(y + i);
+    __m128 vz = _mm_loadu_ps(z + i);
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx),
+                                       _mm_mul_ps(vy, vy)),
+                            _mm_mul_ps(vz, vz));
+    _mm_storeu_ps(result + i, _mm_sqrt_ps(sum));
+  }
+#endif
+  for (; i < length; i++) {
+    result[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+  }
+}
+
+/// @brief Dot products of 3D vectors
+/// @param x X elements of first vectors
+/// @param y Y elements of first vectors
+/// @param z Z elements of first vectors
+/// @param u X elements of second vectors
+/// @param v Y elements of second vectors
+/// @param w Z elements of second vectors
+/// @param result Dot products
+/// @param length Number of vectors
+void ImuPreprocessor::Dot(const float* x, const float* y, const float* z,
+                          const float* u, const float* v, const float* w,
+                          float* result, size_t length) {
+  size_t i = 0;
+#ifdef __SSE__
+  for (; i + 4 <= length; i += 4) {
+    __m128 sum = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(u + i)),
+                   _mm_mul_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(v + i))),
+        _mm_mul_ps(_mm_loadu_ps(z + i), _mm_loadu_ps(w + i)));
+    _mm_storeu_ps(result + i, sum);
+  }
+#endif
+  for (; i < length; i++) {
+    result[i] = x[i] * u[i] + y[i] * v[i] + z[i] * w[i];
+  }
+}
+
+/// @brief Update low-pass gravity estimate, unit vectors are stored
+///        for each rows. This recurrence is sequential and not vectorized.
+/// @param data Imu data
+/// @param begin First row
+/// @param end End of rows
+void ImuPreprocessor::EstimateGravity_(const ImuColumns& data, size_t begin,
+                                       size_t end) {
+  size_t length = end - begin;
+  unit_x_.resize(length);
+  unit_y_.resize(length);
+  unit_z_.resize(length);
+  for (size_t i = begin; i < end; i++) {
+    float acc[3] = {data.acc_x[i], data.acc_y[i], data.acc_z[i]};
+    if (!has_gravity_) {
+      gravity_[0] = acc[0];
+      gravity_[1] = acc[1];
+      gravity_[2] = acc[2];
+      has_gravity_ = true;
+    } else {
+      float dt = data.time[i] - last_time_;
+      float alpha = dt > 0.0 ? dt / (time_constant_ + dt) : 0.0;
+      for (size_t k = 0; k < 3; k++) {
+        gravity_[k] += alpha * (acc[k] - gravity_[k]);
+      }
+    }
+    last_time_ = data.time[i];
+
+    float norm = sqrtf(gravity_[0] * gravity_[0] + gravity_[1] * gravity_[1]
+                       + gravity_[2] * gravity_[2]);
+    float inv = norm > 0.0 ? 1.0 / norm : 0.0;
+    unit_x_[i - begin] = gravity_[0] * inv;
+    unit_y_[i - begin] = gravity_[1] * inv;
+    unit_z_[i - begin] = gravity_[2] * inv;
+  }
+}
+
+}  // namespace
@@ -0,0 +1,392 @@
+/// @file mapped_spectrogram.cpp
+/// @brief Spectrogram stored in chunked memory-mapped file
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/mapped_spectrogram.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace freq_analysis {
+
+namespace {
+
+const char kMagic[4] = {'F', 'Q', 'S', 'P'};
+const uint32_t kVersion = 1;
+
+/// @brief Round up to multiple of page size
+uint64_t RoundUpToPage(uint64_t bytes) {
+  uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  return (bytes + page - 1) / page * page;
+}
+
+}  // namespace
+
+/// @brief Constructor
+/// @param chunk_rows Number of rows in each chunk
+MappedSpectrogramWriter::MappedSpectrogramWriter(uint32_t chunk_rows) :
+    fd_(-1), chunk_rows_(chunk_rows), chunk_(NULL), failed_(false) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+/// @brief Destructor, closes file
+MappedSpectrogramWriter::~MappedSpectrogramWriter() {
+  Close();
+}
+
+/// @brief Create spectrogram file
+/// @return false if file cannot be created
+/// @param filename Spectrogram file
+/// @param freqs Frequencies of bands
+bool MappedSpectrogramWriter::Open(const std::string& filename,
+                                   const std::vector<float>& freqs) {
+  Close();
+  if (freqs.empty() || chunk_rows_ == 0) {
+    return false;
+  }
+  fd_ = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+
+  memset(&header_, 0, sizeof(header_));
+  memcpy(header_.magic, kMagic, sizeof(kMagic));
+  header_.version = kVersion;
+  header_.band_count = freqs.size();
+  header_.chunk_rows = chunk_rows_;
+  header_.chunk_bytes = RoundUpToPage(
+      sizeof(MappedSpectrogramIndex) +
+      sizeof(float) * static_cast<uint64_t>(chunk_rows_) * (1 + freqs.size()));
+  header_.data_offset = RoundUpToPage(
+      sizeof(MappedSpectrogramHeader) + sizeof(float) * freqs.size());
+  failed_ = false;
+
+  size_t freqs_bytes = sizeof(float) * freqs.size();
+  if (!WriteHeader_() ||
+      pwrite(fd_, &freqs[0], freqs_bytes, sizeof(MappedSpectrogramHeader))
+      != static_cast<ssize_t>(freqs_bytes) ||
+      ftruncate(fd_, header_.data_offset) != 0) {
+    std::cerr << "cannot write file: " << filename << std::endl;
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  return true;
+}
+
+/// @brief Append row, file is extended by one chunk when needed
+/// @param time Time of row
+/// @param values Values for each bands
+void MappedSpectrogramWriter::Write(float time,
+                                    const std::vector<float>& values) {
+  if (fd_ < 0 || failed_) {
+    return;
+  }
+  if (!chunk_ && !MapChunk_()) {
+    failed_ = true;
+    return;
+  }
+  MappedSpectrogramIndex* index =
+      reinterpret_cast<MappedSpectrogramIndex*>(chunk_);
+  float* times = reinterpret_cast<float*>(index + 1);
+  size_t bands = header_.band_count;
+  float* row = times + chunk_rows_ + index->rows * bands;
+  size_t copy = values.size() < bands ? values.size() : bands;
+  if (copy > 0) {
+    memcpy(row, &values[0], sizeof(float) * copy);
+  }
+  // rest of row is zero, as new chunks are zero-filled
+
+  if (index->rows == 0) {
+    index->first_time = time;
+  }
+  index->last_time = time;
+  times[index->rows] = time;
+  index->rows++;
+  if (index->rows == chunk_rows_) {
+    UnmapChunk_();
+  }
+}
+
+/// @brief Finish partial chunk and header, then close file
+/// @return false if nothing was open or write failed
+bool MappedSpectrogramWriter::Close() {
+  if (fd_ < 0) {
+    return false;
+  }
+  UnmapChunk_();
+  bool ok = WriteHeader_() && !failed_;
+  close(fd_);
+  fd_ = -1;
+  return ok;
+}
+
+/// @brief Number of rows written
+uint64_t MappedSpectrogramWriter::RowCount() const {
+  uint64_t rows = header_.row_count;
+  if (chunk_) {
+    rows += reinterpret_cast<const MappedSpectrogramIndex*>(chunk_)->rows;
+  }
+  return rows;
+}
+
+/// @brief Bytes currently mapped, at most one chunk
+size_t MappedSpectrogramWriter::MappedBytes() const {
+  return chunk_ ? header_.chunk_bytes : 0;
+}
+
+/// @brief Extend file and map next chunk
+/// @return false if file cannot be extended or mapped
+bool MappedSpectrogramWriter::MapChunk_() {
+  uint64_t offset = header_.data_offset +
+      header_.chunk_count * header_.chunk_bytes;
+  if (ftruncate(fd_, offset + header_.chunk_bytes) != 0) {
+    std::cerr << "cannot extend spectrogram file" << std::endl;
+    return false;
+  }
+  void* addr = mmap(NULL, header_.chunk_bytes, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd_, offset);
+  if (addr == MAP_FAILED) {
+    std::cerr << "cannot map spectrogram chunk" << std::endl;
+    return false;
+  }
+  chunk_ = static_cast<char*>(addr);
+  return true;
+}
+
+/// @brief Unmap current chunk and publish its rows in header
+void MappedSpectrogramWriter::UnmapChunk_() {
+  if (!chunk_) {
+    return;
+  }
+  header_.row_count +=
+      reinterpret_cast<const MappedSpectrogramIndex*>(chunk_)->rows;
+  header_.chunk_count++;
+  // dirty pages are written back by kernel, no msync is needed
+  munmap(chunk_, header_.chunk_bytes);
+  chunk_ = NULL;
+  if (!WriteHeader_()) {
+    failed_ = true;
+  }
+}
+
+/// @brief Rewrite header at head of file
+/// @return false if write failed
+bool MappedSpectrogramWriter::WriteHeader_() {
+  return pwrite(fd_, &header_, sizeof(header_), 0)
+      == static_cast<ssize_t>(sizeof(header_));
+}
+
+/// @brief Constructor
+MappedSpectrogramReader::MappedSpectrogramReader() :
+    addr_(NULL), length_(0) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+/// @brief Destructor, unmaps file
+MappedSpectrogramReader::~MappedSpectrogramReader() {
+  Close();
+}
+
+/// @brief Map spectrogram file, only header, frequencies and chunk index
+///        are read. Rows completed later by writer are not visible until
+///        Refresh.
+/// @return false if file is missing or not a spectrogram file
+/// @param filename Spectrogram file
+bool MappedSpectrogramReader::Open(const std::string& filename) {
+  Close();
+  return Map_(filename);
+}
+
+/// @brief Remap file to see rows completed since Open, views returned by
+///        Row become invalid
+/// @return false if nothing is open or file became invalid, then
+///         previous mapping is kept
+bool MappedSpectrogramReader::Refresh() {
+  if (!addr_) {
+    return false;
+  }
+  std::string filename = filename_;
+  return Map_(filename);
+}
+
+/// @brief Unmap file
+void MappedSpectrogramReader::Close() {
+  if (addr_) {
+    munmap(const_cast<char*>(addr_), length_);
+  }
+  addr_ = NULL;
+  length_ = 0;
+  filename_.clear();
+  memset(&header_, 0, sizeof(header_));
+  freq_list_.clear();
+}
+
+/// @brief Number of bands
+size_t MappedSpectrogramReader::Bands() const {
+  return freq_list_.size();
+}
+
+/// @brief Number of rows at Open or last Refresh
+uint64_t MappedSpectrogramReader::RowCount() const {
+  return header_.row_count;
+}
+
+/// @brief Number of chunks at Open or last Refresh
+uint64_t MappedSpectrogramReader::ChunkCount() const {
+  return header_.chunk_count;
+}
+
+/// @brief Getter of frequencies for each bands
+const std::vector<float>& MappedSpectrogramReader::Frequencies() const {
+  return freq_list_;
+}
+
+/// @brief Time of row
+/// @param row Index of row < RowCount()
+float MappedSpectrogramReader::Time(uint64_t row) const {
+  const MappedSpectrogramIndex* index = Chunk_(row / header_.chunk_rows);
+  return reinterpret_cast<const float*>(index + 1)[row % header_.chunk_rows];
+}
+
+/// @brief View of values of one time, valid until Close or Refresh
+/// @param row Index of row < RowCount()
+SpectrogramView MappedSpectrogramReader::Row(uint64_t row) const {
+  const MappedSpectrogramIndex* index = Chunk_(row / header_.chunk_rows);
+  const float* values = reinterpret_cast<const float*>(index + 1) +
+      header_.chunk_rows + (row % header_.chunk_rows) * header_.band_count;
+  return SpectrogramView(values, header_.band_count, 1);
+}
+
+/// @brief Read rows in time range, only touching chunks in range
+/// @return Number of rows read
+/// @param start Start time, inclusive
+/// @param end End time, inclusive, negative for end of file
+/// @param result Rows in range, layout of result is kept
+uint64_t MappedSpectrogramReader::Read(float start, float end,
+                                       Spectrogram& result) const {
+  result = Spectrogram(freq_list_, result.Layout());
+  if (!addr_) {
+    return 0;
+  }
+  bool to_end = end < 0.0;
+
+  // first chunk which may contain start
+  uint64_t lower = 0;
+  uint64_t upper = header_.chunk_count;
+  while (lower < upper) {
+    uint64_t mid = (lower + upper) / 2;
+    if (Chunk_(mid)->last_time < start) {
+      lower = mid + 1;
+    } else {
+      upper = mid;
+    }
+  }
+
+  size_t bands = header_.band_count;
+  std::vector<float> row(bands);
+  for (uint64_t c = lower; c < header_.chunk_count; c++) {
+    const MappedSpectrogramIndex* index = Chunk_(c);
+    if (!to_end && index->first_time > end) {
+      break;
+    }
+    const float* times = reinterpret_cast<const float*>(index + 1);
+    const float* values = times + header_.chunk_rows;
+    for (size_t r = 0; r < index->rows; r++) {
+      if (times[r] < start || (!to_end && times[r] > end)) {
+        continue;
+      }
+      memcpy(&row[0], values + r * bands, sizeof(float) * bands);
+      result.Append(times[r], row);
+    }
+  }
+  return result.Rows();
+}
+
+/// @brief Map file and validate copy of header against mapped length.
+///        Writer keeps rewriting header of mapped file, so only the copy
+///        is used after this.
+/// @return false if file cannot be mapped or is invalid, then current
+///         mapping is kept
+/// @param filename Spectrogram file
+bool MappedSpectrogramReader::Map_(const std::string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(MappedSpectrogramHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t length = static_cast<size_t>(st.st_size);
+  void* addr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  const char* mapped = static_cast<const char*>(addr);
+  MappedSpectrogramHeader header;
+  memcpy(&header, mapped, sizeof(header));
+
+  // each check keeps following products and sums within length
+  uint64_t min_chunk_bytes = sizeof(MappedSpectrogramIndex) +
+      sizeof(float) * static_cast<uint64_t>(header.chunk_rows) *
+      (1 + static_cast<uint64_t>(header.band_count));
+  bool valid =
+      memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+      header.version == kVersion && header.chunk_rows > 0 &&
+      header.data_offset <= length &&
+      sizeof(MappedSpectrogramHeader) + sizeof(float) *
+      static_cast<uint64_t>(header.band_count) <= header.data_offset &&
+      header.chunk_bytes >= min_chunk_bytes &&
+      header.chunk_count <=
+      (length - header.data_offset) / header.chunk_bytes &&
+      header.row_count <= header.chunk_count * header.chunk_rows;
+  uint64_t rows = 0;
+  for (uint64_t c = 0; valid && c < header.chunk_count; c++) {
+    const MappedSpectrogramIndex* index =
+        reinterpret_cast<const MappedSpectrogramIndex*>(
+            mapped + header.data_offset + c * header.chunk_bytes);
+    valid = index->rows <= header.chunk_rows;
+    rows += index->rows;
+  }
+  if (!valid || rows != header.row_count) {
+    std::cerr << "invalid spectrogram file: " << filename << std::endl;
+    munmap(addr, length);
+    return false;
+  }
+
+  if (addr_) {
+    munmap(const_cast<char*>(addr_), length_);
+  }
+  addr_ = mapped;
+  length_ = length;
+  filename_ = filename;
+  header_ = header;
+  const float* freqs = reinterpret_cast<const float*>(
+      addr_ + sizeof(MappedSpectrogramHeader));
+  freq_list_.assign(freqs, freqs + header_.band_count);
+  return true;
+}
+
+/// @brief Index entry at head of chunk
+/// @param chunk Index of chunk < ChunkCount()
+const MappedSpectrogramIndex* MappedSpectrogramReader::Chunk_(
+    uint64_t chunk) const {
+  return reinterpret_cast<const MappedSpectrogramIndex*>(
+      addr_ + header_.data_offset + chunk * header_.chunk_bytes);
+}
+
+}  // namespace
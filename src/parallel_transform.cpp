@@ -0,0 +1,91 @@
+/// @file parallel_transform.cpp
+/// @brief Offline conversion of long time series split over threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/parallel_transform.hpp"
+
+#include <vector>
+#include <thread>
+
+#include "freq_analysis/wavelet_converter.hpp"
+
+namespace freq_analysis {
+
+/// @brief Constructor
+/// @param bank Filters shared by all segments
+/// @param max_buf_length Max size of buffer of each converter
+/// @param center_t Offset to center of gaussian[s] > 0.0
+ParallelTransform::ParallelTransform(FilterBankPtr bank,
+                                     size_t max_buf_length, float center_t) :
+    bank_(bank), max_buf_length_(max_buf_length), center_t_(center_t) {
+}
+
+/// @brief Convert at every sample from first_convert to end
+/// @param times Time stamps
+/// @param values Values
+/// @param first_convert Index of first sample converted
+/// @param threads Number of threads, also number of segments
+/// @param results Result for each converted samples, with time at center
+///        of wavelets
+void ParallelTransform::Run(const std::vector<float>& times,
+                            const std::vector<float>& values,
+                            size_t first_convert, size_t threads,
+                            Spectrogram& results) {
+  size_t length = times.size() < values.size() ?
+      times.size() : values.size();
+  if (first_convert >= length) {
+    results.Clear();
+    return;
+  }
+  size_t rows = length - first_convert;
+  results.Clear();
+  results.Resize(rows);
+  if (threads == 0) {
+    threads = 1;
+  }
+  if (threads > rows) {
+    threads = rows;
+  }
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; t++) {
+    workers.push_back(std::thread(
+        &ParallelTransform::RunSegment_, this, std::cref(times),
+        std::cref(values), first_convert, rows * t / threads,
+        rows * (t + 1) / threads, std::ref(results)));
+  }
+  RunSegment_(times, values, first_convert, 0, rows / threads, results);
+  for (size_t t = 0; t < workers.size(); t++) {
+    workers[t].join();
+  }
+}
+
+/// @brief Convert single segment
+/// @param times Time stamps
+/// @param values Values
+/// @param first_convert Index of first sample converted
+/// @param begin First row of results in this segment
+/// @param end End of rows of results in this segment
+/// @param results Result for each converted samples
+void ParallelTransform::RunSegment_(const std::vector<float>& times,
+                                    const std::vector<float>& values,
+                                    size_t first_convert,
+                                    size_t begin, size_t end,
+                                    Spectrogram& results) {
+  WaveletConverter conv(bank_, max_buf_length_, center_t_);
+  size_t first = first_convert + begin;
+  size_t warmup = first >= max_buf_length_ ? first - max_buf_length_ + 1 : 0;
+  for (size_t i = warmup; i < first; i++) {
+    conv.AddValue(times[i], values[i]);
+  }
+  std::vector<float> result;
+  for (size_t row = begin; row < end; row++) {
+    size_t i = first_convert + row;
+    conv.AddValue(times[i], values[i]);
+    conv.Convert(result);
+    results.SetRow(row, times[i] - center_t_, result);
+  }
+}
+
+}  // namespace
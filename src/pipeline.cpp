@@ -0,0 +1,104 @@
+/// @file pipeline.cpp
+/// @brief Pipelined read, convert and write stages on separate threads
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/pipeline.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+namespace freq_analysis {
+
+namespace {
+
+double Elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+/// @brief Constructor
+/// @param converter Converter used by converter stage
+/// @param queue_length Capacity of each queue
+ConversionPipeline::ConversionPipeline(WaveletConverterPtr converter,
+                                       size_t queue_length) :
+    converter_(converter), queue_length_(queue_length), wall_seconds_(0.0) {
+}
+
+/// @brief Run all stages until source reaches end and all results are
+///        written. Source runs on calling thread.
+/// @param source Reader stage
+/// @param sink Writer stage
+void ConversionPipeline::Run(const Source& source, const Sink& sink) {
+  SpscQueue<PipelineSample> input_queue(queue_length_);
+  SpscQueue<PipelineRow> output_queue(queue_length_);
+  stats_.assign(3, StageStats());
+  stats_[0].name = "reader";
+  stats_[1].name = "converter";
+  stats_[2].name = "writer";
+  for (size_t i = 0; i < stats_.size(); i++) {
+    stats_[i].items = 0;
+    stats_[i].busy_seconds = 0.0;
+    stats_[i].wall_seconds = 0.0;
+  }
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  std::thread converter_thread([&]() {
+      PipelineSample sample;
+      PipelineRow row;
+      while (input_queue.Pop(sample)) {
+        converter_->AddValue(sample.time, sample.value);
+        stats_[1].items++;
+        if (sample.convert) {
+          row.time = sample.time;
+          converter_->Convert(row.values);
+          output_queue.Push(row);
+        }
+      }
+      output_queue.Close();
+      stats_[1].wall_seconds = Elapsed(start);
+      stats_[1].busy_seconds = stats_[1].wall_seconds
+          - input_queue.ConsumerWait() - output_queue.ProducerWait();
+    });
+
+  std::thread writer_thread([&]() {
+      PipelineRow row;
+      while (output_queue.Pop(row)) {
+        sink(row.time, row.values);
+        stats_[2].items++;
+      }
+      stats_[2].wall_seconds = Elapsed(start);
+      stats_[2].busy_seconds =
+          stats_[2].wall_seconds - output_queue.ConsumerWait();
+    });
+
+  PipelineSample sample;
+  while (source(sample)) {
+    input_queue.Push(sample);
+    stats_[0].items++;
+  }
+  input_queue.Close();
+  stats_[0].wall_seconds = Elapsed(start);
+  stats_[0].busy_seconds =
+      stats_[0].wall_seconds - input_queue.ProducerWait();
+
+  converter_thread.join();
+  writer_thread.join();
+  wall_seconds_ = Elapsed(start);
+}
+
+/// @brief Getter of statistics of reader, converter and writer stages
+const std::vector<StageStats>& ConversionPipeline::Stats() const {
+  return stats_;
+}
+
+/// @brief Wall time of last Run[s]
+double ConversionPipeline::WallSeconds() const {
+  return wall_seconds_;
+}
+
+}  // namespace
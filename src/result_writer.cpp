@@ -0,0 +1,256 @@
+/// @file result_writer.cpp
+/// @brief Writers of converter results in various file formats
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/result_writer.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include <string.h>
+
+namespace freq_analysis {
+
+namespace {
+
+const size_t kBufferSize = 1 << 20;
+
+// header of npy version 1.0 is padded to this length, leaving room
+// to rewrite row count on close
+const size_t kNpyHeaderLength = 128;
+
+}  // namespace
+
+/// @brief Open, write all rows of spectrogram and close
+/// @return false if file cannot be written
+/// @param filename Output file
+/// @param spectrogram Results
+bool ResultWriter::WriteAll(const std::string& filename,
+                            const Spectrogram& spectrogram) {
+  if (!Open(filename, spectrogram.Frequencies())) {
+    return false;
+  }
+  std::vector<float> row;
+  for (size_t i = 0; i < spectrogram.Rows(); i++) {
+    spectrogram.Row(i).CopyTo(row);
+    Write(spectrogram.Times()[i], row);
+  }
+  return Close();
+}
+
+/// @brief Constructor
+TextResultWriter::TextResultWriter() : fp_(NULL) {
+}
+
+/// @brief Destructor, closes file
+TextResultWriter::~TextResultWriter() {
+  Close();
+}
+
+/// @brief Create file and write header
+/// @return false if file cannot be created
+/// @param filename Output file
+/// @param freqs Frequencies for each values
+bool TextResultWriter::Open(const std::string& filename,
+                            const std::vector<float>& freqs) {
+  Close();
+  fp_ = fopen(filename.c_str(), "w");
+  if (!fp_) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  buffer_.resize(kBufferSize);
+  setvbuf(fp_, &buffer_[0], _IOFBF, buffer_.size());
+  fputs("# time", fp_);
+  for (size_t i = 0; i < freqs.size(); i++) {
+    fprintf(fp_, " %g", freqs[i]);
+  }
+  fputc('\n', fp_);
+  return true;
+}
+
+/// @brief Write row
+/// @param time Time
+/// @param values Values for each frequencies
+void TextResultWriter::Write(float time, const std::vector<float>& values) {
+  if (!fp_) {
+    return;
+  }
+  fprintf(fp_, "%g", time);
+  for (size_t i = 0; i < values.size(); i++) {
+    fprintf(fp_, " %g", values[i]);
+  }
+  fputc('\n', fp_);
+}
+
+/// @brief Flush and close file
+/// @return false if nothing was open or write failed
+bool TextResultWriter::Close() {
+  if (!fp_) {
+    return false;
+  }
+  bool ok = !ferror(fp_);
+  ok = (fclose(fp_) == 0) && ok;
+  fp_ = NULL;
+  return ok;
+}
+
+/// @brief Write buffered rows to file
+void TextResultWriter::Flush() {
+  if (fp_) {
+    fflush(fp_);
+  }
+}
+
+/// @brief Constructor
+NpyResultWriter::NpyResultWriter() : fp_(NULL), columns_(0), rows_(0) {
+}
+
+/// @brief Destructor, closes file
+NpyResultWriter::~NpyResultWriter() {
+  Close();
+}
+
+/// @brief Create file and reserve header
+/// @return false if file cannot be created
+/// @param filename Output file
+/// @param freqs Frequencies for each values
+bool NpyResultWriter::Open(const std::string& filename,
+                           const std::vector<float>& freqs) {
+  Close();
+  fp_ = fopen(filename.c_str(), "wb");
+  if (!fp_) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  columns_ = freqs.size() + 1;
+  rows_ = 0;
+  row_.resize(columns_);
+  WriteHeader_();
+  return true;
+}
+
+/// @brief Write row
+/// @param time Time
+/// @param values Values for each frequencies
+void NpyResultWriter::Write(float time, const std::vector<float>& values) {
+  if (!fp_) {
+    return;
+  }
+  row_[0] = time;
+  for (size_t i = 1; i < columns_; i++) {
+    row_[i] = i - 1 < values.size() ? values[i - 1] : 0.0;
+  }
+  fwrite(&row_[0], sizeof(float), columns_, fp_);
+  rows_++;
+}
+
+/// @brief Rewrite header with number of rows and close file
+/// @return false if nothing was open or write failed
+bool NpyResultWriter::Close() {
+  if (!fp_) {
+    return false;
+  }
+  fseek(fp_, 0, SEEK_SET);
+  WriteHeader_();
+  bool ok = !ferror(fp_);
+  ok = (fclose(fp_) == 0) && ok;
+  fp_ = NULL;
+  return ok;
+}
+
+/// @brief Write buffered rows to file
+void NpyResultWriter::Flush() {
+  if (fp_) {
+    fflush(fp_);
+  }
+}
+
+/// @brief Write npy header for current number of rows
+void NpyResultWriter::WriteHeader_() {
+  char dict[kNpyHeaderLength];
+  int length = snprintf(dict, sizeof(dict),
+                        "{'descr': '<f4', 'fortran_order': False, "
+                        "'shape': (%llu, %llu), }",
+                        static_cast<unsigned long long>(rows_),
+                        static_cast<unsigned long long>(columns_));
+  // magic(6) + version(2) + header length(2) + dict, ends with newline
+  size_t dict_length = kNpyHeaderLength - 10;
+  memset(dict + length, ' ', dict_length - length - 1);
+  dict[dict_length - 1] = '\n';
+
+  const char magic[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+  uint8_t header_length[2] = {static_cast<uint8_t>(dict_length & 0xff),
+                              static_cast<uint8_t>(dict_length >> 8)};
+  fwrite(magic, 1, sizeof(magic), fp_);
+  fwrite(header_length, 1, sizeof(header_length), fp_);
+  fwrite(dict, 1, dict_length, fp_);
+}
+
+/// @brief Constructor
+GnuplotBinaryWriter::GnuplotBinaryWriter() : fp_(NULL) {
+}
+
+/// @brief Destructor, closes file
+GnuplotBinaryWriter::~GnuplotBinaryWriter() {
+  Close();
+}
+
+/// @brief Create file and write frequency row
+/// @return false if file cannot be created
+/// @param filename Output file
+/// @param freqs Frequencies for each values
+bool GnuplotBinaryWriter::Open(const std::string& filename,
+                               const std::vector<float>& freqs) {
+  Close();
+  fp_ = fopen(filename.c_str(), "wb");
+  if (!fp_) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  row_.resize(freqs.size() + 1);
+  row_[0] = static_cast<float>(freqs.size());
+  for (size_t i = 0; i < freqs.size(); i++) {
+    row_[i + 1] = freqs[i];
+  }
+  fwrite(&row_[0], sizeof(float), row_.size(), fp_);
+  return true;
+}
+
+/// @brief Write row
+/// @param time Time
+/// @param values Values for each frequencies
+void GnuplotBinaryWriter::Write(float time,
+                                const std::vector<float>& values) {
+  if (!fp_) {
+    return;
+  }
+  row_[0] = time;
+  for (size_t i = 1; i < row_.size(); i++) {
+    row_[i] = i - 1 < values.size() ? values[i - 1] : 0.0;
+  }
+  fwrite(&row_[0], sizeof(float), row_.size(), fp_);
+}
+
+/// @brief Close file
+/// @return false if nothing was open or write failed
+bool GnuplotBinaryWriter::Close() {
+  if (!fp_) {
+    return false;
+  }
+  bool ok = !ferror(fp_);
+  ok = (fclose(fp_) == 0) && ok;
+  fp_ = NULL;
+  return ok;
+}
+
+/// @brief Write buffered rows to file
+void GnuplotBinaryWriter::Flush() {
+  if (fp_) {
+    fflush(fp_);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,27 @@
+/// @file result_writer_factory.cpp
+/// @brief Creation of ResultWriter by name of format
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/result_writer_factory.hpp"
+#include "freq_analysis/mapped_spectrogram.hpp"
+
+namespace freq_analysis {
+
+/// @brief Create writer by name
+/// @return NULL for unknown format
+/// @param format "text", "npy", "gnuplot" or "mapped"
+ResultWriterPtr CreateResultWriter(const std::string& format) {
+  if (format == "text") {
+    return ResultWriterPtr(new TextResultWriter());
+  } else if (format == "npy") {
+    return ResultWriterPtr(new NpyResultWriter());
+  } else if (format == "gnuplot") {
+    return ResultWriterPtr(new GnuplotBinaryWriter());
+  } else if (format == "mapped") {
+    return ResultWriterPtr(new MappedSpectrogramWriter());
+  }
+  return ResultWriterPtr();
+}
+
+}  // namespace
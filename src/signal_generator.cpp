@@ -0,0 +1,273 @@
+/// @file signal_generator.cpp
+/// @brief Reproducible synthetic multi-channel signals for stress tests
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/signal_generator.hpp"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <math.h>
+
+namespace freq_analysis {
+
+namespace {
+
+// jitter is clamped so that sample times stay increasing
+const double kMaxJitter = 0.45;
+
+}  // namespace
+
+/// @brief Constructor
+/// @param channels Number of channels
+/// @param rate Nominal sample rate[Hz]
+/// @param seed Seed of random numbers
+/// @param start_time Time of first sample[s]
+SignalGenerator::SignalGenerator(size_t channels, float rate, uint32_t seed,
+                                 double start_time) :
+    channels_(channels), rate_(rate), seed_(seed), start_time_(start_time),
+    offset_list_(channels, 0.0), jitter_(0.0), dropout_probability_(0.0),
+    dropout_length_(1), reorder_probability_(0.0),
+    pending_values_(channels, 0.0) {
+  Reset();
+}
+
+/// @brief Constant added to channel, e.g. gravity
+/// @param channel Index of channel
+/// @param offset Constant value
+void SignalGenerator::SetOffset(size_t channel, float offset) {
+  if (channel < channels_) {
+    offset_list_[channel] = offset;
+  }
+}
+
+/// @brief Add sine wave
+/// @param channel Index of channel
+/// @param amplitude Amplitude
+/// @param freq Frequency[Hz]
+/// @param phase Phase at time 0[rad]
+void SignalGenerator::AddTone(size_t channel, float amplitude, float freq,
+                              float phase) {
+  SignalComponent component = SignalComponent();
+  component.kind = kSignalTone;
+  component.channel = channel;
+  component.amplitude = amplitude;
+  component.freq = freq;
+  component.phase = phase;
+  component_list_.push_back(component);
+}
+
+/// @brief Add linear frequency sweep, repeated every period
+/// @param channel Index of channel
+/// @param amplitude Amplitude
+/// @param freq_start Frequency at start of sweep[Hz]
+/// @param freq_end Frequency at end of sweep[Hz]
+/// @param period Time of one sweep[s]
+void SignalGenerator::AddChirp(size_t channel, float amplitude,
+                               float freq_start, float freq_end,
+                               float period) {
+  SignalComponent component = SignalComponent();
+  component.kind = kSignalChirp;
+  component.channel = channel;
+  component.amplitude = amplitude;
+  component.freq = freq_start;
+  component.freq_end = freq_end;
+  component.period = period;
+  component_list_.push_back(component);
+}
+
+/// @brief Add periodic impacts of steps. Each step starts with a
+///        sin^2 shaped peak, and period and peak of each step vary.
+/// @param channel Index of channel
+/// @param amplitude Mean peak of impact
+/// @param step_freq Mean steps per second[Hz]
+/// @param duty Fraction of step period with impact, 0.0 to 1.0
+/// @param variation Relative standard deviation of period and peak
+void SignalGenerator::AddGait(size_t channel, float amplitude,
+                              float step_freq, float duty, float variation) {
+  SignalComponent component = SignalComponent();
+  component.kind = kSignalGait;
+  component.channel = channel;
+  component.amplitude = amplitude;
+  component.freq = step_freq;
+  component.duty = std::min(std::max(duty, 0.01f), 1.0f);
+  component.variation = variation;
+  component.step_start = start_time_;
+  component.step_period = 1.0 / step_freq;
+  component.step_amplitude = amplitude;
+  component_list_.push_back(component);
+}
+
+/// @brief Add gaussian white noise
+/// @param channel Index of channel
+/// @param stddev Standard deviation
+void SignalGenerator::AddNoise(size_t channel, float stddev) {
+  SignalComponent component = SignalComponent();
+  component.kind = kSignalNoise;
+  component.channel = channel;
+  component.amplitude = stddev;
+  component_list_.push_back(component);
+}
+
+/// @brief Gaussian jitter of sample times, clamped to 0.45 of period
+/// @param jitter Standard deviation relative to sample period
+void SignalGenerator::SetJitter(float jitter) {
+  jitter_ = jitter;
+}
+
+/// @brief Drop runs of consecutive samples
+/// @param probability Probability that a run starts before each sample
+/// @param max_length Length of run is uniform in 1 to max_length
+void SignalGenerator::SetDropout(float probability, size_t max_length) {
+  dropout_probability_ = probability;
+  dropout_length_ = std::max(max_length, static_cast<size_t>(1));
+}
+
+/// @brief Deliver samples after their successor
+/// @param probability Probability for each sample
+void SignalGenerator::SetReorder(float probability) {
+  reorder_probability_ = probability;
+}
+
+/// @brief Generate next row
+/// @return true, signal does not end
+/// @param time Time of sample[s]
+/// @param values Array of ChannelCount() values
+bool SignalGenerator::Next(double& time, float* values) {
+  if (has_pending_) {
+    time = pending_time_;
+    std::copy(pending_values_.begin(), pending_values_.end(), values);
+    has_pending_ = false;
+  } else {
+    Sample_(time, values);
+    if (reorder_probability_ > 0.0 && Uniform_() < reorder_probability_) {
+      // this sample arrives after next one
+      pending_time_ = time;
+      std::copy(values, values + channels_, pending_values_.begin());
+      has_pending_ = true;
+      Sample_(time, values);
+      reordered_++;
+    }
+  }
+  rows_++;
+  return true;
+}
+
+/// @brief Restart from first sample with same random numbers
+void SignalGenerator::Reset() {
+  rng_.seed(seed_);
+  index_ = 0;
+  rows_ = 0;
+  dropped_ = 0;
+  reordered_ = 0;
+  has_pending_ = false;
+  pending_time_ = 0.0;
+  for (size_t i = 0; i < component_list_.size(); i++) {
+    SignalComponent& component = component_list_[i];
+    if (component.kind == kSignalGait) {
+      component.step_start = start_time_;
+      component.step_period = 1.0 / component.freq;
+      component.step_amplitude = component.amplitude;
+    }
+  }
+}
+
+/// @brief Number of channels
+size_t SignalGenerator::ChannelCount() const {
+  return channels_;
+}
+
+/// @brief Number of rows generated
+uint64_t SignalGenerator::RowCount() const {
+  return rows_;
+}
+
+/// @brief Number of samples dropped
+uint64_t SignalGenerator::DroppedCount() const {
+  return dropped_;
+}
+
+/// @brief Number of samples delivered after their successor
+uint64_t SignalGenerator::ReorderedCount() const {
+  return reordered_;
+}
+
+/// @brief Sample all channels at next sample time, skipping dropouts
+/// @param time Time of sample[s]
+/// @param values Array of ChannelCount() values
+void SignalGenerator::Sample_(double& time, float* values) {
+  if (dropout_probability_ > 0.0 && Uniform_() < dropout_probability_) {
+    uint64_t length = 1 + rng_() % dropout_length_;
+    index_ += length;
+    dropped_ += length;
+  }
+  double period = 1.0 / rate_;
+  time = start_time_ + index_ * period;
+  if (jitter_ > 0.0) {
+    double jitter = std::min(std::max(Normal_() * jitter_, -kMaxJitter),
+                             kMaxJitter);
+    time += jitter * period;
+  }
+  index_++;
+
+  std::copy(offset_list_.begin(), offset_list_.end(), values);
+  for (size_t i = 0; i < component_list_.size(); i++) {
+    SignalComponent& component = component_list_[i];
+    if (component.channel >= channels_) {
+      continue;
+    }
+    float value = 0.0;
+    switch (component.kind) {
+      case kSignalTone:
+        value = component.amplitude *
+            sin(2.0 * M_PI * component.freq * time + component.phase);
+        break;
+      case kSignalChirp: {
+        double tau = fmod(time - start_time_, component.period);
+        double sweep = (component.freq_end - component.freq) /
+            component.period;
+        value = component.amplitude *
+            sin(2.0 * M_PI * (component.freq * tau + 0.5 * sweep * tau * tau));
+        break;
+      }
+      case kSignalGait: {
+        while (time >= component.step_start + component.step_period) {
+          component.step_start += component.step_period;
+          component.step_period = std::max(
+              1.0 + component.variation * Normal_(), 0.1) / component.freq;
+          component.step_amplitude = component.amplitude *
+              std::max(1.0 + component.variation * Normal_(), 0.0);
+        }
+        double u = (time - component.step_start) /
+            (component.step_period * component.duty);
+        if (u >= 0.0 && u < 1.0) {
+          double s = sin(M_PI * u);
+          value = component.step_amplitude * s * s;
+        }
+        break;
+      }
+      case kSignalNoise:
+        value = component.amplitude * Normal_();
+        break;
+    }
+    values[component.channel] += value;
+  }
+}
+
+/// @brief Uniform random number in (0, 1), same on all platforms
+double SignalGenerator::Uniform_() {
+  return (rng_() + 0.5) / 4294967296.0;
+}
+
+/// @brief Standard normal random number by Box-Muller transform,
+///        used instead of std::normal_distribution whose output
+///        differs between standard libraries
+double SignalGenerator::Normal_() {
+  double u1 = Uniform_();
+  double u2 = Uniform_();
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+}  // namespace
@@ -0,0 +1,198 @@
+/// @file spectrogram.cpp
+/// @brief Contiguous time x frequency matrix of converter results
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/spectrogram.hpp"
+
+#include <vector>
+#include <algorithm>
+
+namespace freq_analysis {
+
+/// @brief Copy viewed values
+/// @param result Values
+void SpectrogramView::CopyTo(std::vector<float>& result) const {
+  result.resize(size_);
+  for (size_t i = 0; i < size_; i++) {
+    result[i] = data_[i * stride_];
+  }
+}
+
+/// @brief Constructor
+/// @param freqs Frequencies for each bands
+/// @param layout Storage order
+Spectrogram::Spectrogram(const std::vector<float>& freqs,
+                         SpectrogramLayout layout) :
+    freq_list_(freqs), layout_(layout), capacity_(0) {
+}
+
+/// @brief Add row at end
+/// @param time Time of row
+/// @param values Values for each bands, missing values are 0.0
+void Spectrogram::Append(float time, const std::vector<float>& values) {
+  size_t row = time_list_.size();
+  if (row == capacity_) {
+    Grow_(capacity_ < 16 ? 16 : capacity_ * 2);
+  }
+  time_list_.push_back(time);
+  for (size_t b = 0; b < freq_list_.size(); b++) {
+    data_[Index_(row, b)] = b < values.size() ? values[b] : 0.0;
+  }
+}
+
+/// @brief Reserve storage
+/// @param rows Number of rows
+void Spectrogram::Reserve(size_t rows) {
+  if (rows > capacity_) {
+    Grow_(rows);
+  }
+  time_list_.reserve(rows);
+}
+
+/// @brief Set number of rows, new rows are 0.0
+/// @param rows Number of rows
+void Spectrogram::Resize(size_t rows) {
+  if (rows > capacity_) {
+    Grow_(rows);
+  }
+  if (rows > time_list_.size()) {
+    // clear area which may hold values of removed rows
+    for (size_t b = 0; b < freq_list_.size(); b++) {
+      for (size_t r = time_list_.size(); r < rows; r++) {
+        data_[Index_(r, b)] = 0.0;
+      }
+    }
+  }
+  time_list_.resize(rows, 0.0);
+}
+
+/// @brief Overwrite row, rows may be set from different threads
+/// @param row Index of row < Rows()
+/// @param time Time of row
+/// @param values Values for each bands
+void Spectrogram::SetRow(size_t row, float time,
+                         const std::vector<float>& values) {
+  time_list_[row] = time;
+  for (size_t b = 0; b < freq_list_.size(); b++) {
+    data_[Index_(row, b)] = b < values.size() ? values[b] : 0.0;
+  }
+}
+
+/// @brief Remove all rows, keeping storage
+void Spectrogram::Clear() {
+  time_list_.clear();
+}
+
+/// @brief Number of rows
+size_t Spectrogram::Rows() const {
+  return time_list_.size();
+}
+
+/// @brief Number of bands
+size_t Spectrogram::Bands() const {
+  return freq_list_.size();
+}
+
+/// @brief Getter of storage order
+SpectrogramLayout Spectrogram::Layout() const {
+  return layout_;
+}
+
+/// @brief Value of single element
+/// @param row Index of row
+/// @param band Index of band
+float Spectrogram::At(size_t row, size_t band) const {
+  return data_[Index_(row, band)];
+}
+
+/// @brief Getter of times for each rows
+const std::vector<float>& Spectrogram::Times() const {
+  return time_list_;
+}
+
+/// @brief Getter of frequencies for each bands
+const std::vector<float>& Spectrogram::Frequencies() const {
+  return freq_list_;
+}
+
+/// @brief View of values of one time
+/// @param row Index of row
+SpectrogramView Spectrogram::Row(size_t row) const {
+  if (data_.empty()) {
+    return SpectrogramView(NULL, 0, 1);
+  }
+  if (layout_ == kRowMajor) {
+    return SpectrogramView(&data_[0] + row * freq_list_.size(),
+                           freq_list_.size(), 1);
+  }
+  return SpectrogramView(&data_[0] + row, freq_list_.size(), capacity_);
+}
+
+/// @brief View of values of one frequency for all rows
+/// @param band Index of band
+SpectrogramView Spectrogram::Band(size_t band) const {
+  return Band(band, 0, time_list_.size());
+}
+
+/// @brief View of values of one frequency in rows [row_begin, row_end)
+/// @param band Index of band
+/// @param row_begin First row
+/// @param row_end End of rows
+SpectrogramView Spectrogram::Band(size_t band, size_t row_begin,
+                                  size_t row_end) const {
+  if (row_end > time_list_.size()) {
+    row_end = time_list_.size();
+  }
+  size_t length = row_end > row_begin ? row_end - row_begin : 0;
+  if (data_.empty()) {
+    return SpectrogramView(NULL, 0, 1);
+  }
+  if (layout_ == kRowMajor) {
+    return SpectrogramView(&data_[0] + row_begin * freq_list_.size() + band,
+                           length, freq_list_.size());
+  }
+  return SpectrogramView(&data_[0] + band * capacity_ + row_begin, length, 1);
+}
+
+/// @brief Find rows with start <= time <= end, times must be sorted
+/// @param start Start time
+/// @param end End time
+/// @param row_begin First row in range
+/// @param row_end End of rows in range
+void Spectrogram::TimeRange(float start, float end,
+                            size_t& row_begin, size_t& row_end) const {
+  row_begin = std::lower_bound(time_list_.begin(), time_list_.end(), start)
+      - time_list_.begin();
+  row_end = std::upper_bound(time_list_.begin(), time_list_.end(), end)
+      - time_list_.begin();
+  if (row_end < row_begin) {
+    row_end = row_begin;
+  }
+}
+
+/// @brief Enlarge storage, relayouts values in column-major order
+/// @param rows New capacity
+void Spectrogram::Grow_(size_t rows) {
+  size_t bands = freq_list_.size();
+  if (layout_ == kRowMajor) {
+    data_.resize(rows * bands);
+  } else {
+    std::vector<float> data(rows * bands);
+    for (size_t b = 0; b < bands; b++) {
+      std::copy(data_.begin() + b * capacity_,
+                data_.begin() + b * capacity_ + time_list_.size(),
+                data.begin() + b * rows);
+    }
+    data_.swap(data);
+  }
+  capacity_ = rows;
+}
+
+/// @brief Index of element in storage
+size_t Spectrogram::Index_(size_t row, size_t band) const {
+  return layout_ == kRowMajor ?
+      row * freq_list_.size() + band : band * capacity_ + row;
+}
+
+}  // namespace
@@ -0,0 +1,73 @@
+/// @file spectrum_publisher.cpp
+/// @brief Lock-free publication of the latest converter result
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/spectrum_publisher.hpp"
+
+#include <vector>
+
+namespace freq_analysis {
+
+/// @brief Constructor
+/// @param frequencies Frequencies for each values, fixed for lifetime
+SpectrumPublisher::SpectrumPublisher(const std::vector<float>& frequencies) :
+    freq_list_(frequencies), sequence_(0), time_(0.0),
+    values_(frequencies.size()) {
+  for (size_t i = 0; i < values_.size(); i++) {
+    values_[i].store(0.0, std::memory_order_relaxed);
+  }
+}
+
+/// @brief Publish new values, call from single writer thread only
+/// @param time Time stamp of values
+/// @param values Values, extra elements are ignored
+void SpectrumPublisher::Publish(float time, const std::vector<float>& values) {
+  uint64_t seq = sequence_.load(std::memory_order_relaxed);
+  // odd sequence marks update in progress
+  sequence_.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  time_.store(time, std::memory_order_relaxed);
+  size_t length = values.size() < values_.size() ?
+      values.size() : values_.size();
+  for (size_t i = 0; i < length; i++) {
+    values_[i].store(values[i], std::memory_order_relaxed);
+  }
+
+  sequence_.store(seq + 2, std::memory_order_release);
+}
+
+/// @brief Take consistent snapshot of latest values
+/// @return false when nothing has been published yet
+/// @param spectrum Snapshot
+bool SpectrumPublisher::Read(Spectrum& spectrum) const {
+  spectrum.values.resize(values_.size());
+  spectrum.frequencies.assign(freq_list_.begin(), freq_list_.end());
+  while (true) {
+    uint64_t seq0 = sequence_.load(std::memory_order_acquire);
+    if (seq0 == 0) {
+      return false;
+    }
+    if (seq0 & 1) {
+      continue;
+    }
+    spectrum.time = time_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < values_.size(); i++) {
+      spectrum.values[i] = values_[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t seq1 = sequence_.load(std::memory_order_relaxed);
+    if (seq0 == seq1) {
+      spectrum.sequence = seq0 / 2;
+      return true;
+    }
+  }
+}
+
+/// @brief Number of published spectra
+uint64_t SpectrumPublisher::Sequence() const {
+  return sequence_.load(std::memory_order_acquire) / 2;
+}
+
+}  // namespace
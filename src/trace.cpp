@@ -0,0 +1,203 @@
+/// @file trace.cpp
+/// @brief Scoped trace events written as Chrome trace JSON
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "freq_analysis/trace.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace freq_analysis {
+
+namespace {
+
+/// @brief Events of one thread, appended only by that thread
+struct ThreadBuffer {
+  std::vector<TraceEvent> events;
+  std::atomic<size_t> count;
+  std::atomic<uint64_t> dropped;
+  uint32_t tid;
+  std::string name;
+};
+
+typedef boost::shared_ptr<ThreadBuffer> ThreadBufferPtr;
+
+std::mutex& RegistryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<ThreadBufferPtr>& Registry() {
+  static std::vector<ThreadBufferPtr> registry;
+  return registry;
+}
+
+thread_local ThreadBuffer* t_buffer = NULL;
+
+std::atomic<size_t> g_buffer_events(Tracer::kBufferEvents);
+
+/// @brief Buffer of calling thread, registered at first use
+ThreadBuffer* LocalBuffer() {
+  if (!t_buffer) {
+    ThreadBufferPtr buffer(new ThreadBuffer());
+    buffer->events.resize(g_buffer_events.load(std::memory_order_relaxed));
+    buffer->count.store(0);
+    buffer->dropped.store(0);
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    buffer->tid = Registry().size() + 1;
+    Registry().push_back(buffer);
+    t_buffer = buffer.get();
+  }
+  return t_buffer;
+}
+
+/// @brief Write string as JSON string literal
+void WriteJsonString(FILE* fp, const std::string& str) {
+  fputc('"', fp);
+  for (size_t i = 0; i < str.size(); i++) {
+    char c = str[i];
+    if (c == '"' || c == '\\') {
+      fputc('\\', fp);
+      fputc(c, fp);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      fprintf(fp, "\\u%04x", c);
+    } else {
+      fputc(c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+}  // namespace
+
+const size_t Tracer::kBufferEvents;
+std::atomic<bool> Tracer::enabled_(false);
+
+/// @brief Append complete event to buffer of calling thread
+/// @param name Name of event
+/// @param arg_name Name of argument, NULL for no argument
+/// @param arg Value of argument
+/// @param begin Begin time from Now()
+/// @param end End time from Now()
+void Tracer::Record(const char* name, const char* arg_name, int64_t arg,
+                    int64_t begin, int64_t end) {
+  ThreadBuffer* buffer = LocalBuffer();
+  size_t n = buffer->count.load(std::memory_order_relaxed);
+  if (n >= buffer->events.size()) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  TraceEvent& event = buffer->events[n];
+  event.name = name;
+  event.arg_name = arg_name;
+  event.arg = arg;
+  event.begin = begin;
+  event.end = end;
+  // publish event to Write
+  buffer->count.store(n + 1, std::memory_order_release);
+}
+
+/// @brief Name calling thread in trace
+/// @param name Thread name
+void Tracer::SetThreadName(const std::string& name) {
+  ThreadBuffer* buffer = LocalBuffer();
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  buffer->name = name;
+}
+
+/// @brief Set size of buffers of threads which have not recorded yet
+/// @param events Max number of events per thread
+void Tracer::SetBufferEvents(size_t events) {
+  g_buffer_events.store(events, std::memory_order_relaxed);
+}
+
+/// @brief Write events of all threads as Chrome trace JSON.
+///        Threads may keep recording while writing.
+/// @return false if file cannot be written
+/// @param filename Output file
+bool Tracer::Write(const std::string& filename) {
+  FILE* fp = fopen(filename.c_str(), "w");
+  if (!fp) {
+    std::cerr << "cannot open file: " << filename << std::endl;
+    return false;
+  }
+  int pid = getpid();
+  bool first = true;
+  fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  const std::vector<ThreadBufferPtr>& registry = Registry();
+  for (size_t t = 0; t < registry.size(); t++) {
+    const ThreadBuffer& buffer = *registry[t];
+    if (!buffer.name.empty()) {
+      fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\","
+              "\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+              first ? "" : ",", pid, buffer.tid);
+      WriteJsonString(fp, buffer.name);
+      fprintf(fp, "}}");
+      first = false;
+    }
+    size_t count = buffer.count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+      const TraceEvent& event = buffer.events[i];
+      fprintf(fp, "%s\n{\"name\":", first ? "" : ",");
+      WriteJsonString(fp, event.name);
+      fprintf(fp, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+              "\"ts\":%.3f,\"dur\":%.3f",
+              pid, buffer.tid, event.begin * 1e-3,
+              (event.end - event.begin) * 1e-3);
+      if (event.arg_name) {
+        fprintf(fp, ",\"args\":{");
+        WriteJsonString(fp, event.arg_name);
+        fprintf(fp, ":%lld}", static_cast<long long>(event.arg));
+      }
+      fputc('}', fp);
+      first = false;
+    }
+  }
+  fprintf(fp, "\n]}\n");
+  bool ok = !ferror(fp);
+  fclose(fp);
+  return ok;
+}
+
+/// @brief Discard recorded events, call while no thread is recording
+void Tracer::Clear() {
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  const std::vector<ThreadBufferPtr>& registry = Registry();
+  for (size_t t = 0; t < registry.size(); t++) {
+    registry[t]->count.store(0, std::memory_order_relaxed);
+    registry[t]->dropped.store(0, std::memory_order_relaxed);
+  }
+}
+
+/// @brief Number of recorded events of all threads
+uint64_t Tracer::EventCount() {
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  const std::vector<ThreadBufferPtr>& registry = Registry();
+  uint64_t count = 0;
+  for (size_t t = 0; t < registry.size(); t++) {
+    count += registry[t]->count.load(std::memory_order_acquire);
+  }
+  return count;
+}
+
+/// @brief Number of events dropped since buffers were full
+uint64_t Tracer::DroppedCount() {
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  const std::vector<ThreadBufferPtr>& registry = Registry();
+  uint64_t count = 0;
+  for (size_t t = 0; t < registry.size(); t++) {
+    count += registry[t]->dropped.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+}  // namespace
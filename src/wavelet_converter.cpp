@@ -4,13 +4,26 @@
 /// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
 
 #include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/trace.hpp"
 
 #include <iostream>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <fstream>
+
+#include <stdio.h>
+#include <math.h>
 
 namespace freq_analysis {
 
+namespace {
+
+// weight of newest observed error in drift of pruned filter
+const float kDriftWeight = 0.25;
+
+}  // namespace
+
 /// @brief Constructor
 /// @param start Initial frequency
 /// @param step Ratio of geometric series of frequencies
@@ -20,14 +33,34 @@ namespace freq_analysis {
 WaveletConverter::WaveletConverter(float start, float step, size_t length,
                                    size_t max_buf_length, float center_t,
                                    float sigma) :
-    max_buf_length_(max_buf_length), center_t_(center_t) {
-  float freq = start;
+    WaveletConverter(FilterBankPtr(new FilterBank(start, step, length, sigma)),
+                     max_buf_length, center_t) {
+}
+
+/// @brief Constructor sharing filters with other converters
+/// @param bank Filters
+/// @param max_buf_length Max size of buffer
+/// @param center_t Offset to center of gaussian[s] > 0.0
+WaveletConverter::WaveletConverter(FilterBankPtr bank, size_t max_buf_length,
+                                   float center_t) :
+    bank_(bank), filter_list_(bank->Filters()),
+    freq_list_(bank->Frequencies()),
+    max_buf_length_(max_buf_length), center_t_(center_t),
+    degraded_count_(0), pruning_(false), prune_threshold_(0.0),
+    refresh_interval_(0), value_sum_(0.0), value_sq_sum_(0.0),
+    pruned_count_(0), samples_ingested_(0), convert_calls_(0),
+    evictions_(0) {
+  size_t length = filter_list_.size();
+  last_result_.resize(length, 0.0);
+  eval_std_list_.resize(length, 0.0);
+  age_list_.resize(length, 0);
+  error_estimate_list_.resize(length, 0.0);
+  drift_list_.resize(length, 0.0);
+  band_visited_list_.resize(length, 0);
+  band_ns_list_.resize(length, 0);
+  priority_list_.reserve(length);
   for (size_t i = 0; i < length; i++) {
-    float time_step = 1.0 / freq / 8.0;
-    GaborFilterPtr gabor(new GaborFilter(freq, sigma, time_step));
-    filter_list_.push_back(gabor);
-    freq_list_.push_back(freq);
-    freq *= step;
+    priority_list_.push_back(i);
   }
 }
 
@@ -35,31 +68,243 @@ WaveletConverter::WaveletConverter(float start, float step, size_t length,
 /// @param time Time stamp
 /// @param value Value
 void WaveletConverter::AddValue(float time, float value) {
+  TraceScope trace("AddValue");
   if (time_list_.size() >= max_buf_length_ &&
       value_list_.size() >= max_buf_length_) {
-    time_list_.pop_front();
-    value_list_.pop_front();
+    double front = value_list_.front();
+    value_sum_ -= front;
+    value_sq_sum_ -= front * front;
+    // reuse oldest nodes as newest, buffer does not allocate once full
+    time_list_.splice(time_list_.end(), time_list_, time_list_.begin());
+    value_list_.splice(value_list_.end(), value_list_, value_list_.begin());
+    time_list_.back() = time;
+    value_list_.back() = value;
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+    evictions_++;
+#endif
+  } else {
+    time_list_.push_back(time);
+    value_list_.push_back(value);
+  }
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+  samples_ingested_++;
+#endif
+  value_sum_ += value;
+  value_sq_sum_ += static_cast<double>(value) * value;
+  if (recorder_) {
+    recorder_->AddValue(time, value);
   }
-  time_list_.push_back(time);
-  value_list_.push_back(value);
 }
 
 /// @brief Clear time-seriesed values
 void WaveletConverter::ClearValue() {
   time_list_.clear();
   value_list_.clear();
+  value_sum_ = 0.0;
+  value_sq_sum_ = 0.0;
+  if (recorder_) {
+    recorder_->ClearValue();
+  }
 }
 
 /// @brief Convert time series values into frequency space
 /// @param result Filter result for each filters
 void WaveletConverter::Convert(std::vector<float>& result) {
+  TraceScope trace("Convert");
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+  convert_calls_++;
+#endif
   result.clear();
   float time = time_list_.back() - center_t_;
+  float value_std = ValueStd_();
   for (size_t i = 0; i < filter_list_.size(); i++) {
-    GaborFilterPtr& gabor = filter_list_[i];
-    float value = gabor->Filter(time_list_, value_list_, time);
-    result.push_back(value);
+    if (pruning_ && age_list_[i] < refresh_interval_) {
+      // predict magnitude from change of signal energy since last evaluation
+      float predicted = eval_std_list_[i] > 0.0 ?
+          last_result_[i] * value_std / eval_std_list_[i] :
+          (value_std > 0.0 ? HUGE_VALF : last_result_[i]);
+      if (predicted < prune_threshold_) {
+        result.push_back(last_result_[i]);
+        error_estimate_list_[i] = fabs(predicted - last_result_[i]) +
+            drift_list_[i];
+        age_list_[i]++;
+        pruned_count_++;
+        continue;
+      }
+    }
+    result.push_back(EvaluateBand_(i, time, value_std));
+  }
+  last_result_.assign(result.begin(), result.end());
+  if (publisher_) {
+    publisher_->Publish(time_list_.back(), result);
+  }
+  if (recorder_) {
+    recorder_->Convert(result);
+  }
+}
+
+/// @brief Convert within time budget, evaluating filters in priority order.
+///        Filters not evaluated in time keep their last value.
+/// @return true if all filters were evaluated
+/// @param budget Time budget[s], the first filter is always evaluated
+/// @param result Filter result for each filters
+/// @param stale true for filters holding last value
+bool WaveletConverter::ConvertWithin(double budget, std::vector<float>& result,
+                                     std::vector<bool>& stale) {
+  TraceScope trace("ConvertWithin");
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(budget));
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+  convert_calls_++;
+#endif
+  result.assign(last_result_.begin(), last_result_.end());
+  stale.assign(filter_list_.size(), true);
+
+  float time = time_list_.back() - center_t_;
+  float value_std = ValueStd_();
+  bool complete = true;
+  for (size_t i = 0; i < priority_list_.size(); i++) {
+    if (i > 0 && std::chrono::steady_clock::now() >= deadline) {
+      complete = false;
+      break;
+    }
+    size_t idx = priority_list_[i];
+    result[idx] = EvaluateBand_(idx, time, value_std);
+    stale[idx] = false;
+  }
+  if (!complete) {
+    degraded_count_++;
+  }
+
+  last_result_.assign(result.begin(), result.end());
+  if (publisher_) {
+    publisher_->Publish(time_list_.back(), result);
   }
+  if (recorder_) {
+    recorder_->ConvertWithin(budget, complete, result);
+  }
+  return complete;
+}
+
+/// @brief Set evaluation order for ConvertWithin.
+///        Invalid or duplicated indices are ignored,
+///        missing filters are appended in ascending order.
+/// @param order Indices of filters, highest priority first
+void WaveletConverter::SetPriority(const std::vector<size_t>& order) {
+  std::vector<bool> used(filter_list_.size(), false);
+  priority_list_.clear();
+  for (size_t i = 0; i < order.size(); i++) {
+    if (order[i] < used.size() && !used[order[i]]) {
+      used[order[i]] = true;
+      priority_list_.push_back(order[i]);
+    }
+  }
+  for (size_t i = 0; i < used.size(); i++) {
+    if (!used[i]) {
+      priority_list_.push_back(i);
+    }
+  }
+  if (recorder_) {
+    recorder_->SetPriority(order);
+  }
+}
+
+/// @brief Number of ConvertWithin calls which ran out of budget
+uint64_t WaveletConverter::DegradedCount() const {
+  return degraded_count_;
+}
+
+/// @brief Skip filters with negligible response in Convert.
+///        Response of each filter is predicted from its last value scaled
+///        by change of standard deviation of buffered values, and filters
+///        predicted below threshold reuse their last value. Prediction
+///        assumes the spectrum keeps its shape, so a tone starting in a
+///        pruned band without raising the overall deviation is missed
+///        until the band is refreshed.
+/// @param threshold Filters predicted below this are pruned
+/// @param refresh_interval Pruned filters are evaluated at least once
+///        in this number of Convert calls
+void WaveletConverter::EnablePruning(float threshold,
+                                     size_t refresh_interval) {
+  pruning_ = true;
+  prune_threshold_ = threshold;
+  refresh_interval_ = refresh_interval;
+  // force evaluation of all filters at next Convert, age beyond
+  // refresh interval marks last value as not reused
+  age_list_.assign(filter_list_.size(), refresh_interval + 1);
+  error_estimate_list_.assign(filter_list_.size(), 0.0);
+  drift_list_.assign(filter_list_.size(), 0.0);
+  if (recorder_) {
+    recorder_->EnablePruning(threshold, refresh_interval);
+  }
+}
+
+/// @brief Evaluate all filters in Convert
+void WaveletConverter::DisablePruning() {
+  pruning_ = false;
+  error_estimate_list_.assign(filter_list_.size(), 0.0);
+  if (recorder_) {
+    recorder_->DisablePruning();
+  }
+}
+
+/// @brief Heuristic error of each filter result in last Convert, the
+///        difference between predicted and reused value plus the
+///        running mean of errors found when the filter was refreshed.
+///        This is not a bound: changes seen by neither (e.g. a new tone
+///        in a pruned band, or a ripple in step with refresh interval)
+///        are not included.
+/// @param result Estimated absolute errors, 0.0 for filters evaluated
+///        exactly
+void WaveletConverter::PruningErrorEstimates(std::vector<float>& result) {
+  result.assign(error_estimate_list_.begin(), error_estimate_list_.end());
+}
+
+/// @brief Number of filter evaluations skipped by pruning
+uint64_t WaveletConverter::PrunedCount() const {
+  return pruned_count_;
+}
+
+/// @brief Standard deviation of buffered values
+float WaveletConverter::ValueStd_() const {
+  if (value_list_.empty()) {
+    return 0.0;
+  }
+  double n = static_cast<double>(value_list_.size());
+  double mean = value_sum_ / n;
+  double var = value_sq_sum_ / n - mean * mean;
+  return var > 0.0 ? static_cast<float>(sqrt(var)) : 0.0;
+}
+
+/// @brief Evaluate single filter and record state for pruning
+/// @return Filter result
+/// @param idx Index of filter
+/// @param time Time offset passed to GaborFilter::Filter
+/// @param value_std Current standard deviation of values
+float WaveletConverter::EvaluateBand_(size_t idx, float time,
+                                      float value_std) {
+  TraceScope trace("Filter", "band", idx);
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  float value = filter_list_[idx]->Filter(time_list_, value_list_, time);
+  band_ns_list_[idx] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  band_visited_list_[idx] += time_list_.size();
+#else
+  float value = filter_list_[idx]->Filter(time_list_, value_list_, time);
+#endif
+  if (age_list_[idx] > 0 && age_list_[idx] <= refresh_interval_) {
+    // error of last value reused while pruned
+    drift_list_[idx] += kDriftWeight *
+        (fabs(value - last_result_[idx]) - drift_list_[idx]);
+  }
+  eval_std_list_[idx] = value_std;
+  age_list_[idx] = 0;
+  error_estimate_list_[idx] = 0.0;
+  return value;
 }
 
 /// @brief Getter of frequencies for each filters
@@ -68,4 +313,145 @@ void WaveletConverter::Frequencies(std::vector<float>& result) {
   result.assign(freq_list_.begin(), freq_list_.end());
 }
 
+/// @brief Getter of filters used by this converter
+FilterBankPtr WaveletConverter::Bank() const {
+  return bank_;
+}
+
+/// @brief Publish each result of Convert, NULL pointer disables publishing
+/// @param publisher Publisher created with Frequencies()
+void WaveletConverter::SetPublisher(SpectrumPublisherPtr publisher) {
+  publisher_ = publisher;
+}
+
+/// @brief Record following calls into trace for replay_trace,
+///        NULL pointer stops recording. Recorder is used by one converter.
+///        Trace holds only configuration and calls, so recording starts
+///        only on converter in its initial state.
+/// @return false if recorder is not open or used by other converter,
+///         or converter has buffered values, pruning, priority or results
+/// @param recorder Recorder opened with CallRecorder::Open
+bool WaveletConverter::SetRecorder(CallRecorderPtr recorder) {
+  if (recorder) {
+    if (!Initial_()) {
+      std::cerr << "recorder must be set before converter is used"
+                << std::endl;
+      return false;
+    }
+    CallTraceConfig config;
+    config.start = bank_->Start();
+    config.step = bank_->Step();
+    config.band_count = filter_list_.size();
+    config.sigma = bank_->Sigma();
+    config.table_resolution = bank_->TableResolution();
+    config.max_buf_length = max_buf_length_;
+    config.center_t = center_t_;
+    if (!recorder->Start(config)) {
+      std::cerr << "recorder is not open or already in use" << std::endl;
+      return false;
+    }
+  }
+  recorder_ = recorder;
+  return true;
+}
+
+/// @brief true if state of converter equals that of new one created with
+///        same configuration, so replay of following calls is exact
+bool WaveletConverter::Initial_() const {
+  if (!time_list_.empty() || pruning_) {
+    return false;
+  }
+  for (size_t i = 0; i < priority_list_.size(); i++) {
+    if (priority_list_[i] != i) {
+      return false;
+    }
+  }
+  // kept by ConvertWithin for filters not evaluated in time
+  for (size_t i = 0; i < last_result_.size(); i++) {
+    if (last_result_[i] != 0.0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief Counters since construction or ResetStats, and current state
+/// @param stats Counters and state
+void WaveletConverter::Stats(ConverterStats& stats) const {
+  // node of std::list, without overhead of allocator
+  struct ListNode {
+    void* prev;
+    void* next;
+    float value;
+  };
+  size_t length = filter_list_.size();
+  stats.samples_ingested = samples_ingested_;
+  stats.convert_calls = convert_calls_;
+  stats.evictions = evictions_;
+  stats.buffer_occupancy = time_list_.size();
+  stats.buffer_capacity = max_buf_length_;
+  stats.memory_bytes = sizeof(*this) +
+      (time_list_.size() + value_list_.size()) * sizeof(ListNode) +
+      filter_list_.capacity() * sizeof(GaborFilterPtr) +
+      (freq_list_.capacity() + last_result_.capacity() +
+       eval_std_list_.capacity() + error_estimate_list_.capacity() +
+       drift_list_.capacity()) *
+      sizeof(float) +
+      (priority_list_.capacity() + age_list_.capacity()) * sizeof(size_t) +
+      (band_visited_list_.capacity() + band_ns_list_.capacity()) *
+      sizeof(uint64_t);
+  stats.bank_memory_bytes = 0;
+  for (size_t i = 0; i < length; i++) {
+    stats.bank_memory_bytes += filter_list_[i]->MemoryBytes();
+  }
+  stats.frequencies.assign(freq_list_.begin(), freq_list_.end());
+  stats.band_samples_visited.assign(band_visited_list_.begin(),
+                                    band_visited_list_.end());
+  stats.band_nanoseconds.assign(band_ns_list_.begin(), band_ns_list_.end());
+}
+
+/// @brief Clear counters, filters shared with other converters keep theirs
+void WaveletConverter::ResetStats() {
+  samples_ingested_ = 0;
+  convert_calls_ = 0;
+  evictions_ = 0;
+  band_visited_list_.assign(filter_list_.size(), 0);
+  band_ns_list_.assign(filter_list_.size(), 0);
+}
+
+/// @brief Write stats as "key value" lines. File is written to a
+///        temporary file and renamed, so readers never see partial file.
+/// @return false if file cannot be written
+/// @param filename Output file
+bool WaveletConverter::DumpStats(const std::string& filename) const {
+  ConverterStats stats;
+  Stats(stats);
+  std::string tmpname = filename + ".tmp";
+  {
+    std::ofstream file(tmpname.c_str());
+    if (!file) {
+      std::cerr << "cannot open file: " << tmpname << std::endl;
+      return false;
+    }
+    file << "samples_ingested " << stats.samples_ingested << '\n'
+         << "convert_calls " << stats.convert_calls << '\n'
+         << "evictions " << stats.evictions << '\n'
+         << "buffer_occupancy " << stats.buffer_occupancy << '\n'
+         << "buffer_capacity " << stats.buffer_capacity << '\n'
+         << "memory_bytes " << stats.memory_bytes << '\n'
+         << "bank_memory_bytes " << stats.bank_memory_bytes << '\n';
+    for (size_t i = 0; i < stats.frequencies.size(); i++) {
+      file << "band." << i << ".frequency " << stats.frequencies[i] << '\n'
+           << "band." << i << ".samples_visited "
+           << stats.band_samples_visited[i] << '\n'
+           << "band." << i << ".nanoseconds "
+           << stats.band_nanoseconds[i] << '\n';
+    }
+    if (!file) {
+      return false;
+    }
+  }
+  return rename(tmpname.c_str(), filename.c_str()) == 0;
+}
+
 }  // namespace
@@ -0,0 +1,104 @@
+/// @file allocation_counter.cpp
+/// @brief Replacement of global operator new/delete counting allocations
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include "allocation_counter.hpp"
+
+#include <new>
+
+#include <stdlib.h>
+
+namespace {
+
+// trivially constructed, usable from allocations before main
+thread_local freq_analysis::AllocationCount t_count = {0, 0, 0, 0};
+
+// size of each block is stored in header before returned pointer,
+// header keeps alignment of malloc
+const size_t kHeaderBytes = 16;
+
+void* CountedAlloc(size_t size) {
+  void* block = malloc(size + kHeaderBytes);
+  if (!block) {
+    return NULL;
+  }
+  *static_cast<size_t*>(block) = size;
+  t_count.allocations++;
+  t_count.bytes_allocated += size;
+  return static_cast<char*>(block) + kHeaderBytes;
+}
+
+void CountedFree(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  void* block = static_cast<char*>(ptr) - kHeaderBytes;
+  t_count.deallocations++;
+  t_count.bytes_deallocated += *static_cast<size_t*>(block);
+  free(block);
+}
+
+void* CountedNew(size_t size) {
+  void* ptr = CountedAlloc(size);
+  while (!ptr) {
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+    ptr = CountedAlloc(size);
+  }
+  return ptr;
+}
+
+}  // namespace
+
+namespace freq_analysis {
+
+/// @brief Totals of calling thread
+AllocationCount ThreadAllocationCount() {
+  return t_count;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedNew(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedNew(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  CountedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  CountedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  CountedFree(ptr);
+}
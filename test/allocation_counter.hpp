@@ -0,0 +1,59 @@
+/// @file allocation_counter.hpp
+/// @brief Counters of global operator new/delete for allocation tests
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#ifndef FREQ_ANALYSIS_ALLOCATION_COUNTER_HPP_
+#define FREQ_ANALYSIS_ALLOCATION_COUNTER_HPP_
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace freq_analysis {
+
+/// @brief Totals of calling thread since start of program.
+/// Linking allocation_counter.cpp replaces global operator new/delete,
+/// which update these totals.
+struct AllocationCount {
+  uint64_t allocations;
+  uint64_t deallocations;
+  uint64_t bytes_allocated;
+  uint64_t bytes_deallocated;
+};
+
+AllocationCount ThreadAllocationCount();
+
+/// @brief Allocations of calling thread from construction of scope.
+/// Allocations of other threads, e.g. workers of library, are not counted.
+class AllocationScope {
+ public:
+  AllocationScope() : start_(ThreadAllocationCount()) {
+  }
+
+  uint64_t Allocations() const {
+    return ThreadAllocationCount().allocations - start_.allocations;
+  }
+  uint64_t Deallocations() const {
+    return ThreadAllocationCount().deallocations - start_.deallocations;
+  }
+  uint64_t BytesAllocated() const {
+    return ThreadAllocationCount().bytes_allocated - start_.bytes_allocated;
+  }
+  uint64_t BytesDeallocated() const {
+    return ThreadAllocationCount().bytes_deallocated -
+        start_.bytes_deallocated;
+  }
+  /// @brief Bytes allocated in scope and not yet freed, negative if
+  ///        memory allocated before scope was freed
+  int64_t LiveBytes() const {
+    return static_cast<int64_t>(BytesAllocated()) -
+        static_cast<int64_t>(BytesDeallocated());
+  }
+
+ private:
+  AllocationCount start_;
+};
+
+}  // namespace
+
+#endif  // FREQ_ANALYSIS_ALLOCATION_COUNTER_HPP_
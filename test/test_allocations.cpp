@@ -0,0 +1,154 @@
+/// @file test_allocations.cpp
+/// @brief Allocation budgets of WaveletConverter
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <math.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "allocation_counter.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::AllocationScope;
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::WaveletConverter;
+
+class AllocationTest : public testing::Test {
+ protected:
+  // counts are taken into locals before assertions, since gtest allocates
+
+  void CounterTest() {
+    AllocationScope scope;
+    // operator new is called directly, since optimiser may remove a
+    // new expression paired with delete
+    void* value = ::operator new(sizeof(int));
+    uint64_t allocations = scope.Allocations();
+    uint64_t bytes = scope.BytesAllocated();
+    ::operator delete(value);
+    EXPECT_EQ(allocations, 1u);
+    EXPECT_EQ(bytes, sizeof(int));
+    EXPECT_EQ(scope.Deallocations(), 1u);
+    EXPECT_EQ(scope.LiveBytes(), 0);
+  }
+
+  void ConstructTest() {
+    size_t bands_list[] = {5, 50};
+    uint64_t shared_allocations[2];
+    for (size_t n = 0; n < 2; n++) {
+      size_t bands = bands_list[n];
+      AllocationScope scope;
+      {
+        WaveletConverter conv(0.5, 1.1, bands, 256, 1.0);
+        uint64_t allocations = scope.Allocations();
+        // GaborFilter, its shared_ptr and two value tables per band
+        EXPECT_LE(allocations, 4 * bands + 16);
+
+        FilterBankPtr bank = conv.Bank();
+        AllocationScope shared_scope;
+        WaveletConverter shared(bank, 256, 1.0);
+        shared_allocations[n] = shared_scope.Allocations();
+      }
+      int64_t live = scope.LiveBytes();
+      EXPECT_EQ(live, 0);
+    }
+    // converter sharing filters allocates only its own state
+    EXPECT_LE(shared_allocations[0], 10u);
+    EXPECT_EQ(shared_allocations[0], shared_allocations[1]);
+  }
+
+  void IngestTest() {
+    const size_t buf_length = 256;
+    WaveletConverter conv(0.5, 1.1, 20, buf_length, 1.0);
+    float t = 0.0;
+    uint64_t fill_allocations;
+    {
+      AllocationScope scope;
+      for (size_t i = 0; i < buf_length; i++, t += 0.01) {
+        conv.AddValue(t, sin(t));
+      }
+      fill_allocations = scope.Allocations();
+    }
+    // one list node per time and value
+    EXPECT_LE(fill_allocations, 2 * buf_length);
+
+    AllocationScope scope;
+    for (size_t i = 0; i < 10 * buf_length; i++, t += 0.01) {
+      conv.AddValue(t, sin(t));
+    }
+    uint64_t allocations = scope.Allocations();
+    uint64_t deallocations = scope.Deallocations();
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(deallocations, 0u);
+  }
+
+  void ConvertTest() {
+    WaveletConverter conv(0.5, 1.1, 20, 256, 1.0);
+    float t = 0.0;
+    for (size_t i = 0; i < 256; i++, t += 0.01) {
+      conv.AddValue(t, sin(t));
+    }
+    std::vector<float> result;
+    std::vector<bool> stale;
+    // first calls size result vectors
+    conv.Convert(result);
+    conv.ConvertWithin(10.0, result, stale);
+
+    uint64_t convert_allocations;
+    {
+      AllocationScope scope;
+      for (size_t i = 0; i < 20; i++, t += 0.01) {
+        conv.AddValue(t, sin(t));
+        conv.Convert(result);
+      }
+      convert_allocations = scope.Allocations();
+    }
+    EXPECT_EQ(convert_allocations, 0u);
+
+    uint64_t within_allocations;
+    {
+      AllocationScope scope;
+      for (size_t i = 0; i < 20; i++, t += 0.01) {
+        conv.AddValue(t, sin(t));
+        conv.ConvertWithin(10.0, result, stale);
+      }
+      within_allocations = scope.Allocations();
+    }
+    EXPECT_EQ(within_allocations, 0u);
+
+    conv.EnablePruning(1.0, 4);
+    conv.Convert(result);
+    uint64_t pruned_allocations;
+    {
+      AllocationScope scope;
+      for (size_t i = 0; i < 20; i++, t += 0.01) {
+        conv.AddValue(t, sin(t));
+        conv.Convert(result);
+      }
+      pruned_allocations = scope.Allocations();
+    }
+    EXPECT_EQ(pruned_allocations, 0u);
+  }
+};
+
+TEST_F(AllocationTest, Counter) {
+  CounterTest();
+}
+
+TEST_F(AllocationTest, Construct) {
+  ConstructTest();
+}
+
+TEST_F(AllocationTest, SteadyStateIngest) {
+  IngestTest();
+}
+
+TEST_F(AllocationTest, Convert) {
+  ConvertTest();
+}
@@ -0,0 +1,103 @@
+/// @file test_batch_layout.cpp
+/// @brief Test for BatchLayout
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "freq_analysis/batch_layout.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::BatchLayout;
+
+namespace fs = std::filesystem;
+
+class BatchLayoutTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    root_ = fs::temp_directory_path() / "test_batch_layout";
+    fs::remove_all(root_);
+    fs::create_directories(root_ / "a");
+    fs::create_directories(root_ / "b");
+    Touch_(root_ / "a" / "left_leg.dat");
+    Touch_(root_ / "b" / "left_leg.dat");
+  }
+
+  virtual void TearDown() {
+    fs::remove_all(root_);
+  }
+
+  void SameNameTest() {
+    BatchLayout layout("out", ".result.dat");
+    std::vector<std::string> inputs;
+    inputs.push_back((root_ / "a" / "left_leg.dat").string());
+    inputs.push_back((root_ / "b" / "left_leg.dat").string());
+    ASSERT_TRUE(layout.Plan(inputs));
+    ASSERT_EQ(layout.Outputs().size(), 2u);
+    EXPECT_NE(layout.Outputs()[0], layout.Outputs()[1]);
+    EXPECT_EQ(layout.Outputs()[0],
+              (fs::path("out") / "a" / "left_leg").string() + ".result.dat");
+    EXPECT_EQ(layout.Outputs()[1],
+              (fs::path("out") / "b" / "left_leg").string() + ".result.dat");
+    EXPECT_EQ(fs::path(layout.Root()), fs::weakly_canonical(root_));
+  }
+
+  void SingleDirectoryTest() {
+    // files of one directory are written directly below output directory
+    BatchLayout layout("out", ".result.dat");
+    std::vector<std::string> inputs;
+    inputs.push_back((root_ / "a" / "left_leg.dat").string());
+    ASSERT_TRUE(layout.Plan(inputs));
+    EXPECT_EQ(layout.Outputs()[0],
+              (fs::path("out") / "left_leg").string() + ".result.dat");
+  }
+
+  void DuplicateTest() {
+    // same file given twice is processed once
+    BatchLayout layout("out", ".result.dat");
+    std::vector<std::string> inputs;
+    inputs.push_back((root_ / "a" / "left_leg.dat").string());
+    inputs.push_back((root_ / "a" / ".." / "a" / "left_leg.dat").string());
+    ASSERT_TRUE(layout.Plan(inputs));
+    EXPECT_EQ(layout.Inputs().size(), 1u);
+  }
+
+  void CollisionTest() {
+    // different files with same stem in same directory
+    Touch_(root_ / "a" / "left_leg.txt");
+    BatchLayout layout("out", ".result.dat");
+    std::vector<std::string> inputs;
+    inputs.push_back((root_ / "a" / "left_leg.dat").string());
+    inputs.push_back((root_ / "a" / "left_leg.txt").string());
+    EXPECT_FALSE(layout.Plan(inputs));
+  }
+
+ private:
+  fs::path root_;
+
+  void Touch_(const fs::path& path) {
+    std::ofstream file(path.string().c_str());
+    file << "0 0 0 0 0 0 0" << std::endl;
+  }
+};
+
+TEST_F(BatchLayoutTest, SameNameInDifferentDirectories) {
+  SameNameTest();
+}
+
+TEST_F(BatchLayoutTest, SingleDirectory) {
+  SingleDirectoryTest();
+}
+
+TEST_F(BatchLayoutTest, DuplicatedInput) {
+  DuplicateTest();
+}
+
+TEST_F(BatchLayoutTest, CollisionIsRejected) {
+  CollisionTest();
+}
@@ -0,0 +1,248 @@
+/// @file test_call_recorder.cpp
+/// @brief Test for CallRecorder and CallTrace
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <math.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/call_recorder.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::CallRecord;
+using freq_analysis::CallRecorder;
+using freq_analysis::CallRecorderPtr;
+using freq_analysis::CallTrace;
+using freq_analysis::CallTraceConfig;
+using freq_analysis::WaveletConverter;
+
+class CallRecorderTest : public testing::Test {
+ protected:
+  // calls of every recorded type, results are appended to outputs
+  void Run(WaveletConverter& conv,
+           std::vector<std::vector<float> >& outputs) {
+    std::vector<float> result;
+    std::vector<bool> stale;
+    for (int i = 0; i < 300; i++) {
+      float t = i * 0.01;
+      conv.AddValue(t, sin(2.0 * M_PI * 2.0 * t));
+      if (i % 50 == 49) {
+        conv.Convert(result);
+        outputs.push_back(result);
+      }
+    }
+    std::vector<size_t> order(1, 2);
+    conv.SetPriority(order);
+    conv.ConvertWithin(10.0, result, stale);
+    outputs.push_back(result);
+    conv.EnablePruning(0.5, 3);
+    conv.Convert(result);
+    outputs.push_back(result);
+    conv.DisablePruning();
+    conv.ClearValue();
+    conv.AddValue(0.0, 1.0);
+    conv.Convert(result);
+    outputs.push_back(result);
+  }
+
+  void RecordTest() {
+    std::string filename("test_call_recorder.trace");
+    std::vector<std::vector<float> > outputs;
+    {
+      WaveletConverter conv(0.5, 2.0, 4, 128, 1.0, 1.5);
+      CallRecorderPtr recorder(new CallRecorder());
+      // not opened
+      EXPECT_FALSE(conv.SetRecorder(recorder));
+      ASSERT_TRUE(recorder->Open(filename));
+      ASSERT_TRUE(conv.SetRecorder(recorder));
+      // recorder belongs to one converter
+      WaveletConverter other(conv.Bank(), 128, 1.0);
+      EXPECT_FALSE(other.SetRecorder(recorder));
+
+      Run(conv, outputs);
+      // 301 AddValue, 9 conversions and 4 other calls
+      EXPECT_EQ(recorder->RecordCount(), 314u);
+      EXPECT_TRUE(recorder->Close());
+    }
+
+    CallTrace trace;
+    ASSERT_TRUE(trace.Read(filename));
+    remove(filename.c_str());
+    const CallTraceConfig& config = trace.Config();
+    EXPECT_FLOAT_EQ(config.start, 0.5);
+    EXPECT_FLOAT_EQ(config.step, 2.0);
+    EXPECT_EQ(config.band_count, 4u);
+    EXPECT_FLOAT_EQ(config.sigma, 1.5);
+    EXPECT_EQ(config.max_buf_length, 128u);
+    EXPECT_FLOAT_EQ(config.center_t, 1.0);
+    ASSERT_TRUE(trace.HasResults());
+    ASSERT_EQ(trace.size(), 314u);
+    EXPECT_EQ(trace[0].type, freq_analysis::kCallAddValue);
+    EXPECT_FLOAT_EQ(trace[1].time, 0.01);
+
+    // replay into converter created from config gives same results
+    WaveletConverter replay(config.start, config.step, config.band_count,
+                            config.max_buf_length, config.center_t,
+                            config.sigma);
+    std::vector<float> result;
+    std::vector<bool> stale;
+    size_t converted = 0;
+    for (size_t i = 0; i < trace.size(); i++) {
+      const CallRecord& record = trace[i];
+      switch (record.type) {
+        case freq_analysis::kCallAddValue:
+          replay.AddValue(record.time, record.value);
+          break;
+        case freq_analysis::kCallClearValue:
+          replay.ClearValue();
+          break;
+        case freq_analysis::kCallConvert:
+          replay.Convert(result);
+          break;
+        case freq_analysis::kCallConvertWithin:
+          EXPECT_TRUE(record.complete);
+          replay.ConvertWithin(record.budget, result, stale);
+          break;
+        case freq_analysis::kCallEnablePruning:
+          EXPECT_EQ(record.count, 3u);
+          replay.EnablePruning(record.value, record.count);
+          break;
+        case freq_analysis::kCallDisablePruning:
+          replay.DisablePruning();
+          break;
+        case freq_analysis::kCallSetPriority: {
+          ASSERT_EQ(record.count, 1u);
+          EXPECT_EQ(trace.Indices(record)[0], 2u);
+          std::vector<size_t> order(trace.Indices(record),
+                                    trace.Indices(record) + record.count);
+          replay.SetPriority(order);
+          break;
+        }
+      }
+      if (record.type == freq_analysis::kCallConvert ||
+          record.type == freq_analysis::kCallConvertWithin) {
+        ASSERT_LT(converted, outputs.size());
+        ASSERT_EQ(record.count, 4u);
+        const float* recorded = trace.Results(record);
+        for (size_t b = 0; b < result.size(); b++) {
+          EXPECT_EQ(recorded[b], outputs[converted][b]);
+          EXPECT_EQ(result[b], recorded[b]);
+        }
+        converted++;
+      }
+    }
+    EXPECT_EQ(converted, outputs.size());
+  }
+
+  void NoResultTest() {
+    std::string filename("test_call_recorder_nores.trace");
+    {
+      WaveletConverter conv(0.5, 2.0, 4, 128, 1.0);
+      CallRecorderPtr recorder(new CallRecorder());
+      ASSERT_TRUE(recorder->Open(filename, false));
+      ASSERT_TRUE(conv.SetRecorder(recorder));
+      std::vector<std::vector<float> > outputs;
+      Run(conv, outputs);
+      // stop recording, later calls are not recorded
+      conv.SetRecorder(CallRecorderPtr());
+      conv.AddValue(10.0, 1.0);
+    }
+
+    CallTrace trace;
+    ASSERT_TRUE(trace.Read(filename));
+    remove(filename.c_str());
+    EXPECT_FALSE(trace.HasResults());
+    ASSERT_EQ(trace.size(), 314u);
+    for (size_t i = 0; i < trace.size(); i++) {
+      if (trace[i].type == freq_analysis::kCallConvert) {
+        EXPECT_TRUE(trace.Results(trace[i]) == NULL);
+      }
+    }
+  }
+
+  void InitialStateTest() {
+    std::string filename("test_call_recorder_initial.trace");
+    CallRecorderPtr recorder(new CallRecorder());
+    ASSERT_TRUE(recorder->Open(filename));
+    // buffered values are not in trace
+    WaveletConverter conv(0.5, 2.0, 4, 128, 1.0);
+    conv.AddValue(0.0, 1.0);
+    EXPECT_FALSE(conv.SetRecorder(recorder));
+    // results kept by ConvertWithin are not in trace
+    std::vector<float> result;
+    conv.Convert(result);
+    conv.ClearValue();
+    EXPECT_FALSE(conv.SetRecorder(recorder));
+
+    WaveletConverter pruned(0.5, 2.0, 4, 128, 1.0);
+    pruned.EnablePruning(0.5, 3);
+    EXPECT_FALSE(pruned.SetRecorder(recorder));
+    pruned.DisablePruning();
+    EXPECT_TRUE(pruned.SetRecorder(recorder));
+    EXPECT_TRUE(recorder->Close());
+    remove(filename.c_str());
+  }
+
+  void CorruptTest() {
+    std::string filename("test_call_recorder_corrupt.trace");
+    {
+      WaveletConverter conv(0.5, 2.0, 4, 128, 1.0);
+      CallRecorderPtr recorder(new CallRecorder());
+      ASSERT_TRUE(recorder->Open(filename));
+      ASSERT_TRUE(conv.SetRecorder(recorder));
+      conv.AddValue(0.0, 1.0);
+      EXPECT_TRUE(recorder->Close());
+    }
+    // priority with count far beyond end of file
+    FILE* fp = fopen(filename.c_str(), "ab");
+    ASSERT_TRUE(fp != NULL);
+    uint8_t type = freq_analysis::kCallSetPriority;
+    uint32_t count = 0xffffffffu;
+    fwrite(&type, sizeof(type), 1, fp);
+    fwrite(&count, sizeof(count), 1, fp);
+    fclose(fp);
+
+    CallTrace trace;
+    ASSERT_TRUE(trace.Read(filename));
+    EXPECT_EQ(trace.size(), 1u);
+
+    // results of huge band count beyond end of file
+    freq_analysis::CallTraceHeader header;
+    fp = fopen(filename.c_str(), "r+b");
+    ASSERT_TRUE(fp != NULL);
+    ASSERT_EQ(fread(&header, sizeof(header), 1, fp), 1u);
+    header.band_count = 0x40000000u;
+    type = freq_analysis::kCallConvert;
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fp);
+    fseek(fp, sizeof(header) + 9, SEEK_SET);
+    fwrite(&type, sizeof(type), 1, fp);
+    fclose(fp);
+    ASSERT_TRUE(trace.Read(filename));
+    EXPECT_EQ(trace.size(), 1u);
+    remove(filename.c_str());
+  }
+};
+
+TEST_F(CallRecorderTest, RecordAndReplay) {
+  RecordTest();
+}
+
+TEST_F(CallRecorderTest, WithoutResults) {
+  NoResultTest();
+}
+
+TEST_F(CallRecorderTest, OnlyInitialConverter) {
+  InitialStateTest();
+}
+
+TEST_F(CallRecorderTest, CorruptCounts) {
+  CorruptTest();
+}
@@ -0,0 +1,153 @@
+/// @file test_columnar_log.cpp
+/// @brief Test for ColumnarLogWriter and ColumnarLogReader
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+
+#include "freq_analysis/columnar_log.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ColumnarLogReader;
+using freq_analysis::ColumnarLogWriter;
+
+class ColumnarLogTest : public testing::Test {
+ protected:
+  void WriteReadTest() {
+    std::string filename("test_columnar_log.bin");
+    std::vector<std::string> names;
+    names.push_back("time");
+    names.push_back("a");
+    names.push_back("b");
+
+    // 1000 rows at 0.01[s] in blocks of 64 rows
+    ColumnarLogWriter writer;
+    ASSERT_TRUE(writer.Open(filename, names, 64));
+    for (int i = 0; i < 1000; i++) {
+      float row[3] = {i * 0.01f, static_cast<float>(i),
+                      static_cast<float>(-i)};
+      writer.Write(row);
+    }
+    ASSERT_TRUE(writer.Close());
+
+    ColumnarLogReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    EXPECT_EQ(reader.RowCount(), 1000u);
+    ASSERT_EQ(reader.ColumnCount(), 3u);
+    EXPECT_EQ(reader.ColumnIndex("b"), 2);
+    EXPECT_EQ(reader.ColumnIndex("c"), -1);
+
+    // only column b in range [2.0, 3.0]
+    std::vector<size_t> columns(1, 2);
+    std::vector<std::vector<float> > values;
+    EXPECT_EQ(reader.Read(2.0, 3.0, columns, values), 101u);
+    ASSERT_EQ(values.size(), 1u);
+    ASSERT_EQ(values[0].size(), 101u);
+    EXPECT_EQ(values[0].front(), -200.0);
+    EXPECT_EQ(values[0].back(), -300.0);
+
+    // first row past end, also from following block
+    EXPECT_EQ(reader.Read(2.0, 3.0, columns, values, 1), 102u);
+    EXPECT_EQ(values[0].back(), -301.0);
+    EXPECT_EQ(reader.Read(2.0, 3.835, columns, values, 2), 186u);
+    EXPECT_EQ(values[0].back(), -385.0);
+
+    // open end
+    columns.assign(1, 0);
+    EXPECT_EQ(reader.Read(9.5, -1.0, columns, values), 50u);
+    EXPECT_FLOAT_EQ(values[0].back(), 9.99);
+
+    reader.Close();
+    remove(filename.c_str());
+  }
+
+  void LongTimeTest() {
+    // float step is 8 ms after one day, offsets keep 10 ms rows apart
+    std::string filename("test_columnar_log_long.bin");
+    std::vector<std::string> names;
+    names.push_back("time");
+    names.push_back("a");
+    ColumnarLogWriter writer;
+    ASSERT_TRUE(writer.Open(filename, names, 64));
+    const double start = 86400.0;
+    for (int i = 0; i < 1000; i++) {
+      float value = static_cast<float>(i);
+      writer.Write(start + i * 0.01, &value);
+    }
+    ASSERT_TRUE(writer.Close());
+
+    ColumnarLogReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    std::vector<size_t> columns(1, 1);
+    std::vector<std::vector<float> > values;
+    std::vector<double> times;
+    EXPECT_EQ(reader.Read(start + 1.995, start + 2.995, columns, values, 0,
+                          &times), 100u);
+    ASSERT_EQ(times.size(), 100u);
+    for (size_t i = 0; i < times.size(); i++) {
+      EXPECT_EQ(values[0][i], 200.0 + i);
+      EXPECT_NEAR(times[i], start + 2.0 + i * 0.01, 1e-5);
+    }
+    reader.Close();
+    remove(filename.c_str());
+  }
+
+  void CorruptIndexTest() {
+    std::string filename("test_columnar_log_corrupt.bin");
+    std::vector<std::string> names(2, "x");
+    ColumnarLogWriter writer;
+    ASSERT_TRUE(writer.Open(filename, names, 16));
+    for (int i = 0; i < 40; i++) {
+      float row[2] = {i * 0.01f, static_cast<float>(i)};
+      writer.Write(row);
+    }
+    ASSERT_TRUE(writer.Close());
+
+    freq_analysis::ColumnarLogHeader header;
+    FILE* fp = fopen(filename.c_str(), "r+b");
+    ASSERT_TRUE(fp != NULL);
+    ASSERT_EQ(fread(&header, sizeof(header), 1, fp), 1u);
+    ASSERT_EQ(header.block_count, 3u);
+
+    // offset of last block beyond end of file
+    freq_analysis::ColumnarLogIndex index;
+    long position = header.index_offset + 2 * sizeof(index);
+    fseek(fp, position, SEEK_SET);
+    ASSERT_EQ(fread(&index, sizeof(index), 1, fp), 1u);
+    uint64_t offset = index.offset;
+    index.offset = 1ull << 40;
+    fseek(fp, position, SEEK_SET);
+    ASSERT_EQ(fwrite(&index, sizeof(index), 1, fp), 1u);
+    fflush(fp);
+    ColumnarLogReader reader;
+    EXPECT_FALSE(reader.Open(filename));
+
+    // rows of last block beyond block size
+    index.offset = offset;
+    index.rows = 1000;
+    fseek(fp, position, SEEK_SET);
+    ASSERT_EQ(fwrite(&index, sizeof(index), 1, fp), 1u);
+    fclose(fp);
+    EXPECT_FALSE(reader.Open(filename));
+    EXPECT_EQ(reader.RowCount(), 0u);
+    remove(filename.c_str());
+  }
+};
+
+TEST_F(ColumnarLogTest, WriteRead) {
+  WriteReadTest();
+}
+
+TEST_F(ColumnarLogTest, LongTime) {
+  LongTimeTest();
+}
+
+TEST_F(ColumnarLogTest, CorruptIndex) {
+  CorruptIndexTest();
+}
@@ -0,0 +1,124 @@
+/// @file test_conversion_driver.cpp
+/// @brief Test for ConversionDriver
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <math.h>
+
+#include "freq_analysis/conversion_driver.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ConversionDriver;
+using freq_analysis::DriverStats;
+using freq_analysis::WaveletConverter;
+using freq_analysis::WaveletConverterPtr;
+
+class ConversionDriverTest : public testing::Test {
+ protected:
+  void PeriodicTest() {
+    WaveletConverterPtr conv(new WaveletConverter(5.0, 2.0, 5, 1024, 0.0));
+    ConversionDriver driver(conv, 50.0);
+
+    std::atomic<int> count(0);
+    std::atomic<size_t> length(0);
+    std::atomic<float> latest(0.0);
+    driver.AddCallback([&](float time, const std::vector<float>& result) {
+        count++;
+        length = result.size();
+        latest = time;
+      });
+
+    float omega = 2.0 * M_PI * 20.0;
+    float last = 0.0;
+    for (float t = -0.5; t < 0.5; t += 0.003) {
+      driver.AddValue(t, sin(omega * t));
+      last = t;
+    }
+
+    ASSERT_TRUE(driver.Start());
+    EXPECT_FALSE(driver.Start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    driver.Stop();
+
+    DriverStats stats = driver.Stats();
+    // 50Hz for 0.3s, allow slack for loaded machines
+    EXPECT_GT(count.load(), 5);
+    EXPECT_EQ(static_cast<uint64_t>(count.load()), stats.conversions);
+    EXPECT_EQ(length.load(), 5u);
+    // time stamp of latest value
+    EXPECT_EQ(latest.load(), last);
+    EXPECT_GE(stats.max_jitter, stats.mean_jitter);
+    EXPECT_GE(stats.mean_jitter, 0.0);
+  }
+
+  void StopTest() {
+    // Stop wakes thread sleeping for a long period
+    WaveletConverterPtr conv(new WaveletConverter(5.0, 2.0, 5, 1024, 0.0));
+    ConversionDriver driver(conv, 0.001);
+    ASSERT_TRUE(driver.Start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    driver.Stop();
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    EXPECT_LT(elapsed, 1.0);
+    EXPECT_EQ(driver.Stats().ticks, 0u);
+  }
+
+  void ReentrantTest() {
+    // callback adding callback does not deadlock
+    WaveletConverterPtr conv(new WaveletConverter(5.0, 2.0, 5, 1024, 0.0));
+    ConversionDriver driver(conv, 50.0);
+    std::atomic<int> added(0);
+    std::atomic<int> count(0);
+    driver.AddCallback([&](float, const std::vector<float>&) {
+        if (added.exchange(1) == 0) {
+          driver.AddCallback([&](float, const std::vector<float>&) {
+              count++;
+            });
+        }
+      });
+    driver.AddValue(0.0, 1.0);
+    ASSERT_TRUE(driver.Start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    driver.Stop();
+    EXPECT_EQ(added.load(), 1);
+    EXPECT_GT(count.load(), 0);
+  }
+
+  void InvalidRateTest() {
+    WaveletConverterPtr conv(new WaveletConverter(5.0, 2.0, 5, 1024, 0.0));
+    const float rates[] = {0.0, -50.0, NAN};
+    for (size_t i = 0; i < 3; i++) {
+      ConversionDriver driver(conv, rates[i]);
+      EXPECT_FALSE(driver.Start());
+      EXPECT_EQ(driver.Stats().ticks, 0u);
+    }
+  }
+};
+
+TEST_F(ConversionDriverTest, PeriodicConvert) {
+  PeriodicTest();
+}
+
+TEST_F(ConversionDriverTest, StopWhileSleeping) {
+  StopTest();
+}
+
+TEST_F(ConversionDriverTest, CallbackAddsCallback) {
+  ReentrantTest();
+}
+
+TEST_F(ConversionDriverTest, InvalidRate) {
+  InvalidRateTest();
+}
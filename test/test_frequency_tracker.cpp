@@ -0,0 +1,77 @@
+/// @file test_frequency_tracker.cpp
+/// @brief Test for FrequencyTracker
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <list>
+
+#include <math.h>
+
+#include "freq_analysis/frequency_tracker.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::FrequencyTracker;
+using freq_analysis::TrackResult;
+
+class FrequencyTrackerTest : public testing::Test {
+ protected:
+  void TrackTest() {
+    // coarse grid: 0.25 to 4.0 [Hz] with 9 filters, resolution 0.01 [Hz]
+    FrequencyTracker tracker(0.25, 4.0, 9, 0.01, 1.0);
+
+    const float in_freqs[] = {0.6, 1.37, 2.05};
+    for (size_t n = 0; n < 3; n++) {
+      std::list<float> time_list;
+      std::list<float> value_list;
+      float omega = 2.0 * M_PI * in_freqs[n];
+      for (float t = -10.0; t < 10.0; t += 0.01) {
+        time_list.push_back(t);
+        value_list.push_back(sin(omega * t));
+      }
+
+      TrackResult result = tracker.Track(time_list, value_list, 0.0);
+      EXPECT_NEAR(result.frequency, in_freqs[n], 0.01);
+      EXPECT_GT(result.magnitude, 10.0);
+      EXPECT_GT(result.confidence, 0.0);
+      EXPECT_LE(result.confidence, 1.0);
+      // dense grid with 0.01[Hz] step needs 375 filters
+      EXPECT_LT(result.evaluated, 40u);
+    }
+    EXPECT_LE(tracker.CachedFilters(), 32u);
+  }
+
+  void EdgeTest() {
+    // quantum is 0.25 [Hz], so 0.1 [Hz] rounds to key of frequency 0
+    FrequencyTracker tracker(0.1, 4.0, 9, 1.0, 1.0);
+
+    // constant walks down to lowest key, tone above range to highest key
+    const float in_freqs[] = {0.0, 6.0};
+    for (size_t n = 0; n < 2; n++) {
+      std::list<float> time_list;
+      std::list<float> value_list;
+      float omega = 2.0 * M_PI * in_freqs[n];
+      for (float t = -10.0; t < 10.0; t += 0.01) {
+        time_list.push_back(t);
+        value_list.push_back(cos(omega * t));
+      }
+
+      TrackResult result = tracker.Track(time_list, value_list, 0.0);
+      EXPECT_GT(result.frequency, 0.0);
+      EXPECT_LE(result.frequency, 4.0);
+      EXPECT_TRUE(isfinite(result.magnitude));
+    }
+  }
+};
+
+TEST_F(FrequencyTrackerTest, DominantFrequency) {
+  TrackTest();
+}
+
+TEST_F(FrequencyTrackerTest, EdgeOfRange) {
+  EdgeTest();
+}
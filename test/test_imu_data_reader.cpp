@@ -0,0 +1,78 @@
+/// @file test_imu_data_reader.cpp
+/// @brief Test for ImuDataReader
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freq_analysis/imu_data_reader.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+
+class ImuDataReaderTest : public testing::Test {
+ protected:
+  void ParseLineTest() {
+    float fields[ImuDataReader::kFields];
+    const char* line = "0.010146 0.398948 9.347334 5.841272 -0.1 -0.2 0.3";
+    ASSERT_TRUE(ImuDataReader::ParseLine(line, line + strlen(line), fields));
+    EXPECT_FLOAT_EQ(fields[0], 0.010146);
+    EXPECT_FLOAT_EQ(fields[2], 9.347334);
+    EXPECT_FLOAT_EQ(fields[6], 0.3);
+
+    const char* comment = "# time acc.x acc.y acc.z gyro.x gyro.y gyro.z";
+    EXPECT_FALSE(ImuDataReader::ParseLine(comment, comment + strlen(comment),
+                                          fields));
+    const char* shorter = "0.0 1.0 2.0";
+    EXPECT_FALSE(ImuDataReader::ParseLine(shorter, shorter + strlen(shorter),
+                                          fields));
+    const char* invalid = "0.0 1.0 2.0 x 4.0 5.0 6.0";
+    EXPECT_FALSE(ImuDataReader::ParseLine(invalid, invalid + strlen(invalid),
+                                          fields));
+  }
+
+  void ParallelReadTest() {
+    std::string filename("test_imu_data_reader.dat");
+    FILE* fp = fopen(filename.c_str(), "w");
+    ASSERT_TRUE(fp != NULL);
+    fprintf(fp, "# time acc.x acc.y acc.z gyro.x gyro.y gyro.z\n");
+    const size_t rows = 100000;
+    for (size_t i = 0; i < rows; i++) {
+      fprintf(fp, "%f %f %f %f %f %f %f\n", i * 0.01, 1.0, 2.0, 3.0,
+              -1.0, -2.0, static_cast<float>(i));
+    }
+    fclose(fp);
+
+    ImuColumns single;
+    ImuColumns multi;
+    ImuDataReader reader1(1);
+    ImuDataReader reader4(4);
+    ASSERT_TRUE(reader1.Read(filename, single));
+    ASSERT_TRUE(reader4.Read(filename, multi));
+    remove(filename.c_str());
+
+    ASSERT_EQ(single.size(), rows);
+    ASSERT_EQ(multi.size(), rows);
+    for (size_t i = 0; i < rows; i++) {
+      ASSERT_EQ(single.time[i], multi.time[i]);
+      ASSERT_EQ(multi.gyro_z[i], static_cast<float>(i));
+    }
+    EXPECT_FALSE(reader1.Read("no_such_file.dat", single));
+  }
+};
+
+TEST_F(ImuDataReaderTest, ParseLine) {
+  ParseLineTest();
+}
+
+TEST_F(ImuDataReaderTest, ParallelRead) {
+  ParallelReadTest();
+}
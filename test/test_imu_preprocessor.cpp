@@ -0,0 +1,64 @@
+/// @file test_imu_preprocessor.cpp
+/// @brief Test for ImuPreprocessor
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <math.h>
+
+#include "freq_analysis/imu_preprocessor.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuPreprocessor;
+using freq_analysis::DerivedChannel;
+
+class ImuPreprocessorTest : public testing::Test {
+ protected:
+  void ChannelTest() {
+    ImuColumns data;
+    for (int i = 0; i < 103; i++) {
+      float t = i * 0.01;
+      // gravity along z with small oscillation
+      float row[7] = {t, 0.5f * sinf(t * 10.0f), 0.3f, 9.8f,
+                      0.1f * i, -0.2f, 0.3f};
+      data.push_back(row);
+    }
+
+    std::vector<DerivedChannel> channels;
+    channels.push_back(freq_analysis::kAccNorm);
+    channels.push_back(freq_analysis::kGyroNorm);
+    channels.push_back(freq_analysis::kGyroX);
+    channels.push_back(freq_analysis::kAccGravity);
+    ImuPreprocessor preprocessor(channels, 1.0);
+    ASSERT_EQ(preprocessor.ChannelCount(), 4u);
+
+    std::vector<std::vector<float> > result;
+    preprocessor.Process(data, 1, data.size(), result);
+    ASSERT_EQ(result.size(), 4u);
+    for (size_t i = 1; i < data.size(); i++) {
+      float ax = data.acc_x[i];
+      float ay = data.acc_y[i];
+      float az = data.acc_z[i];
+      // same as per-sample computation in sample_walking
+      float abs_acc = sqrt(ax * ax + ay * ay + az * az);
+      ASSERT_EQ(result[0][i - 1], abs_acc);
+      float gx = data.gyro_x[i];
+      float gy = data.gyro_y[i];
+      float gz = data.gyro_z[i];
+      EXPECT_FLOAT_EQ(result[1][i - 1], sqrt(gx * gx + gy * gy + gz * gz));
+      EXPECT_EQ(result[2][i - 1], gx);
+      // gravity is almost z, projection is almost z element
+      EXPECT_NEAR(result[3][i - 1], az, 0.1);
+    }
+  }
+};
+
+TEST_F(ImuPreprocessorTest, DerivedChannels) {
+  ChannelTest();
+}
@@ -0,0 +1,133 @@
+/// @file test_mapped_spectrogram.cpp
+/// @brief Test for MappedSpectrogramWriter and MappedSpectrogramReader
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "freq_analysis/mapped_spectrogram.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::MappedSpectrogramWriter;
+using freq_analysis::MappedSpectrogramReader;
+using freq_analysis::Spectrogram;
+using freq_analysis::SpectrogramView;
+
+class MappedSpectrogramTest : public testing::Test {
+ protected:
+  void WriteRows(MappedSpectrogramWriter& writer, size_t begin, size_t end) {
+    std::vector<float> values(3);
+    for (size_t r = begin; r < end; r++) {
+      for (size_t i = 0; i < values.size(); i++) {
+        values[i] = r * 10.0f + i;
+      }
+      writer.Write(r * 0.01f, values);
+    }
+  }
+
+  void ReadWriteTest() {
+    std::string filename("test_mapped_spectrogram.spec");
+    std::vector<float> freqs;
+    freqs.push_back(0.5f);
+    freqs.push_back(1.0f);
+    freqs.push_back(2.0f);
+
+    MappedSpectrogramWriter writer(1000);
+    ASSERT_TRUE(writer.Open(filename, freqs));
+    WriteRows(writer, 0, 2500);
+    ASSERT_EQ(writer.RowCount(), 2500u);
+    // only current chunk is mapped
+    ASSERT_GT(writer.MappedBytes(), 0u);
+    ASSERT_LT(writer.MappedBytes(), 1000u * 4 * sizeof(float) + 8192);
+
+    {
+      // completed chunks are visible before Close
+      MappedSpectrogramReader reader;
+      ASSERT_TRUE(reader.Open(filename));
+      ASSERT_EQ(reader.RowCount(), 2000u);
+      ASSERT_EQ(reader.ChunkCount(), 2u);
+
+      // counts are kept until Refresh while writer goes on
+      WriteRows(writer, 2500, 3456);
+      ASSERT_EQ(reader.RowCount(), 2000u);
+      ASSERT_EQ(reader.Time(1999), 1999 * 0.01f);
+      Spectrogram result(freqs, freq_analysis::kRowMajor);
+      ASSERT_EQ(reader.Read(0.0f, -1.0f, result), 2000u);
+      ASSERT_TRUE(reader.Refresh());
+      ASSERT_EQ(reader.RowCount(), 3000u);
+      ASSERT_EQ(reader.ChunkCount(), 3u);
+    }
+
+    ASSERT_TRUE(writer.Close());
+
+    MappedSpectrogramReader reader;
+    ASSERT_TRUE(reader.Open(filename));
+    ASSERT_EQ(reader.Frequencies(), freqs);
+    ASSERT_EQ(reader.Bands(), 3u);
+    ASSERT_EQ(reader.RowCount(), 3456u);
+    ASSERT_EQ(reader.ChunkCount(), 4u);
+    ASSERT_EQ(reader.Time(3455), 3455 * 0.01f);
+    SpectrogramView row = reader.Row(1234);
+    ASSERT_EQ(row.size(), 3u);
+    ASSERT_EQ(row[2], 12342.0f);
+
+    // range across chunk boundary
+    Spectrogram result(freqs, freq_analysis::kColumnMajor);
+    ASSERT_EQ(reader.Read(9.95f, 10.05f, result), 11u);
+    ASSERT_EQ(result.Layout(), freq_analysis::kColumnMajor);
+    ASSERT_EQ(result.Times()[0], 995 * 0.01f);
+    ASSERT_EQ(result.At(5, 1), 10001.0f);
+
+    ASSERT_EQ(reader.Read(30.0f, -1.0f, result), 456u);
+    ASSERT_EQ(result.At(455, 0), 34550.0f);
+    ASSERT_EQ(reader.Read(100.0f, 200.0f, result), 0u);
+
+    reader.Close();
+    unlink(filename.c_str());
+  }
+
+  void CorruptIndexTest() {
+    std::string filename("test_mapped_spectrogram_corrupt.spec");
+    std::vector<float> freqs(3, 1.0f);
+    MappedSpectrogramWriter writer(100);
+    ASSERT_TRUE(writer.Open(filename, freqs));
+    WriteRows(writer, 0, 250);
+    ASSERT_TRUE(writer.Close());
+
+    // rows of second chunk beyond chunk_rows
+    freq_analysis::MappedSpectrogramHeader header;
+    int fd = open(filename.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(pread(fd, &header, sizeof(header), 0),
+              static_cast<ssize_t>(sizeof(header)));
+    freq_analysis::MappedSpectrogramIndex index;
+    off_t offset = header.data_offset + header.chunk_bytes;
+    ASSERT_EQ(pread(fd, &index, sizeof(index), offset),
+              static_cast<ssize_t>(sizeof(index)));
+    index.rows = 100000;
+    ASSERT_EQ(pwrite(fd, &index, sizeof(index), offset),
+              static_cast<ssize_t>(sizeof(index)));
+    close(fd);
+
+    MappedSpectrogramReader reader;
+    ASSERT_FALSE(reader.Open(filename));
+    ASSERT_EQ(reader.RowCount(), 0u);
+    unlink(filename.c_str());
+  }
+};
+
+TEST_F(MappedSpectrogramTest, ReadWrite) {
+  ReadWriteTest();
+}
+
+TEST_F(MappedSpectrogramTest, CorruptIndex) {
+  CorruptIndexTest();
+}
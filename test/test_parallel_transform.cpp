@@ -0,0 +1,67 @@
+/// @file test_parallel_transform.cpp
+/// @brief Test for ParallelTransform
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <math.h>
+
+#include "freq_analysis/parallel_transform.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::ParallelTransform;
+using freq_analysis::Spectrogram;
+using freq_analysis::WaveletConverter;
+
+class ParallelTransformTest : public testing::Test {
+ protected:
+  void SequentialMatchTest() {
+    FilterBankPtr bank(new FilterBank(0.5, sqrt(2.0), 8, 1.0));
+    std::vector<float> times;
+    std::vector<float> values;
+    for (int i = 0; i < 3000; i++) {
+      float t = i * 0.01;
+      times.push_back(t);
+      values.push_back(sin(2.0 * M_PI * (0.5 + 0.1 * t) * t));
+    }
+
+    // sequential reference
+    size_t first_convert = 200;
+    WaveletConverter conv(bank, 256, 2.0);
+    std::vector<std::vector<float> > expected;
+    for (size_t i = 0; i < times.size(); i++) {
+      conv.AddValue(times[i], values[i]);
+      if (i >= first_convert) {
+        std::vector<float> result;
+        conv.Convert(result);
+        expected.push_back(result);
+      }
+    }
+
+    ParallelTransform transform(bank, 256, 2.0);
+    for (size_t threads = 1; threads <= 5; threads += 2) {
+      Spectrogram results(bank->Frequencies());
+      transform.Run(times, values, first_convert, threads, results);
+      ASSERT_EQ(results.Rows(), expected.size());
+      std::vector<float> row;
+      for (size_t i = 0; i < results.Rows(); i++) {
+        // bit-identical
+        results.Row(i).CopyTo(row);
+        ASSERT_EQ(row, expected[i]);
+        ASSERT_EQ(results.Times()[i], times[first_convert + i] - 2.0f);
+      }
+    }
+  }
+};
+
+TEST_F(ParallelTransformTest, SequentialMatch) {
+  SequentialMatchTest();
+}
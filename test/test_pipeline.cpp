@@ -0,0 +1,141 @@
+/// @file test_pipeline.cpp
+/// @brief Test for SpscQueue and ConversionPipeline
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <math.h>
+#include <time.h>
+
+#include "freq_analysis/pipeline.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ConversionPipeline;
+using freq_analysis::PipelineSample;
+using freq_analysis::SpscQueue;
+using freq_analysis::StageStats;
+using freq_analysis::WaveletConverter;
+using freq_analysis::WaveletConverterPtr;
+
+class PipelineTest : public testing::Test {
+ protected:
+  void QueueTest() {
+    // small queue forces producer to wait for consumer
+    SpscQueue<int> queue(4);
+    const int count = 100000;
+    int64_t sum = 0;
+    int last = -1;
+    bool ordered = true;
+    std::thread consumer([&]() {
+        int item;
+        while (queue.Pop(item)) {
+          ordered = ordered && item == last + 1;
+          last = item;
+          sum += item;
+        }
+      });
+    for (int i = 0; i < count; i++) {
+      int item = i;
+      queue.Push(item);
+    }
+    queue.Close();
+    consumer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(last, count - 1);
+    EXPECT_EQ(sum, static_cast<int64_t>(count) * (count - 1) / 2);
+  }
+
+  void IdleTest() {
+    // consumer waiting on empty queue sleeps instead of spinning
+    SpscQueue<int> queue(4);
+    int received = -1;
+    std::thread consumer([&]() {
+        int item;
+        while (queue.Pop(item)) {
+          received = item;
+        }
+      });
+    clock_t cpu_start = clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    double cpu_seconds = static_cast<double>(clock() - cpu_start)
+        / CLOCKS_PER_SEC;
+    int item = 7;
+    queue.Push(item);
+    queue.Close();
+    consumer.join();
+    EXPECT_EQ(received, 7);
+    EXPECT_LT(cpu_seconds, 0.1);
+    EXPECT_GT(queue.ConsumerWait(), 0.25);
+  }
+
+  void PipelineRunTest() {
+    WaveletConverterPtr conv(new WaveletConverter(5.0, 2.0, 5, 1024, 0.0));
+    WaveletConverter reference(5.0, 2.0, 5, 1024, 0.0);
+
+    float omega = 2.0 * M_PI * 20.0;
+    float t = -0.5;
+    ConversionPipeline::Source source = [&](PipelineSample& sample) {
+      if (t >= 0.5) {
+        return false;
+      }
+      sample.time = t;
+      sample.value = sin(omega * t);
+      sample.convert = t > 0.0;
+      t += 0.003;
+      return true;
+    };
+
+    std::vector<std::vector<float> > results;
+    std::vector<float> times;
+    ConversionPipeline::Sink sink =
+        [&](float time, const std::vector<float>& result) {
+      results.push_back(result);
+      times.push_back(time);
+    };
+
+    ConversionPipeline pipeline(conv, 16);
+    pipeline.Run(source, sink);
+
+    // same results as sequential conversion
+    std::vector<std::vector<float> > expected;
+    std::vector<float> expected_times;
+    for (float s = -0.5; s < 0.5; s += 0.003) {
+      reference.AddValue(s, sin(omega * s));
+      if (s > 0.0) {
+        std::vector<float> result;
+        reference.Convert(result);
+        expected.push_back(result);
+        expected_times.push_back(s);
+      }
+    }
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t i = 0; i < results.size(); i++) {
+      ASSERT_EQ(results[i], expected[i]);
+      ASSERT_EQ(times[i], expected_times[i]);
+    }
+
+    const std::vector<StageStats>& stats = pipeline.Stats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[0].items, stats[1].items);
+    EXPECT_EQ(stats[2].items, results.size());
+  }
+};
+
+TEST_F(PipelineTest, BoundedQueue) {
+  QueueTest();
+}
+
+TEST_F(PipelineTest, IdleConsumerSleeps) {
+  IdleTest();
+}
+
+TEST_F(PipelineTest, ConvertInPipeline) {
+  PipelineRunTest();
+}
@@ -0,0 +1,111 @@
+/// @file test_result_writer.cpp
+/// @brief Test for ResultWriter implementations
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freq_analysis/result_writer_factory.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::ResultWriterPtr;
+using freq_analysis::CreateResultWriter;
+
+class ResultWriterTest : public testing::Test {
+ protected:
+  void WriteRows(const std::string& format, const std::string& filename) {
+    ResultWriterPtr writer = CreateResultWriter(format);
+    ASSERT_TRUE(writer.get() != NULL);
+    std::vector<float> freqs;
+    freqs.push_back(1.0);
+    freqs.push_back(2.0);
+    ASSERT_TRUE(writer->Open(filename, freqs));
+    for (int i = 0; i < 3; i++) {
+      std::vector<float> values(2, static_cast<float>(i));
+      values[1] = 0.5;
+      writer->Write(i * 0.25f, values);
+    }
+    EXPECT_TRUE(writer->Close());
+  }
+
+  std::string ReadFile(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    remove(filename.c_str());
+    return content;
+  }
+
+  void TextTest() {
+    WriteRows("text", "test_result_writer.dat");
+    EXPECT_EQ(ReadFile("test_result_writer.dat"),
+              "# time 1 2\n0 0 0.5\n0.25 1 0.5\n0.5 2 0.5\n");
+  }
+
+  void FlushTest() {
+    // rows are in file after Flush, before Close
+    std::string filename("test_result_writer_flush.dat");
+    ResultWriterPtr writer = CreateResultWriter("text");
+    std::vector<float> freqs(1, 1.0);
+    ASSERT_TRUE(writer->Open(filename, freqs));
+    writer->Write(0.5f, freqs);
+    writer->Flush();
+    std::ifstream file(filename.c_str());
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "# time 1\n0.5 1\n");
+    EXPECT_TRUE(writer->Close());
+    remove(filename.c_str());
+  }
+
+  void NpyTest() {
+    WriteRows("npy", "test_result_writer.npy");
+    std::string content = ReadFile("test_result_writer.npy");
+    ASSERT_EQ(content.size(), 128u + 3 * 3 * sizeof(float));
+    EXPECT_EQ(content.substr(1, 5), "NUMPY");
+    EXPECT_NE(content.find("'shape': (3, 3)"), std::string::npos);
+    EXPECT_EQ(content[127], '\n');
+    float row[3];
+    memcpy(row, content.data() + 128 + 2 * sizeof(row), sizeof(row));
+    EXPECT_EQ(row[0], 0.5);
+    EXPECT_EQ(row[1], 2.0);
+    EXPECT_EQ(row[2], 0.5);
+  }
+
+  void GnuplotTest() {
+    WriteRows("gnuplot", "test_result_writer.bin");
+    std::string content = ReadFile("test_result_writer.bin");
+    ASSERT_EQ(content.size(), 4 * 3 * sizeof(float));
+    float row[3];
+    memcpy(row, content.data(), sizeof(row));
+    EXPECT_EQ(row[0], 2.0);
+    EXPECT_EQ(row[1], 1.0);
+    EXPECT_EQ(row[2], 2.0);
+    EXPECT_TRUE(CreateResultWriter("unknown").get() == NULL);
+  }
+};
+
+TEST_F(ResultWriterTest, Text) {
+  TextTest();
+}
+
+TEST_F(ResultWriterTest, TextFlush) {
+  FlushTest();
+}
+
+TEST_F(ResultWriterTest, Npy) {
+  NpyTest();
+}
+
+TEST_F(ResultWriterTest, GnuplotBinary) {
+  GnuplotTest();
+}
@@ -0,0 +1,132 @@
+/// @file test_signal_generator.cpp
+/// @brief Test for SignalGenerator
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <math.h>
+
+#include "freq_analysis/signal_generator.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::SignalGenerator;
+using freq_analysis::WaveletConverter;
+
+class SignalGeneratorTest : public testing::Test {
+ protected:
+  void Configure(SignalGenerator& generator) {
+    generator.SetOffset(1, 9.8);
+    generator.AddTone(0, 1.0, 2.0);
+    generator.AddChirp(1, 1.0, 1.0, 5.0, 10.0);
+    generator.AddGait(2, 3.0, 1.8);
+    generator.AddNoise(0, 0.1);
+    generator.SetJitter(0.1);
+    generator.SetDropout(0.01, 5);
+    generator.SetReorder(0.01);
+  }
+
+  void SeedTest() {
+    SignalGenerator a(3, 100.0, 7);
+    SignalGenerator b(3, 100.0, 7);
+    SignalGenerator c(3, 100.0, 8);
+    Configure(a);
+    Configure(b);
+    Configure(c);
+    std::vector<double> times;
+    std::vector<float> values;
+    double ta, tb, tc;
+    float va[3], vb[3], vc[3];
+    bool differs = false;
+    for (int i = 0; i < 5000; i++) {
+      a.Next(ta, va);
+      b.Next(tb, vb);
+      c.Next(tc, vc);
+      ASSERT_EQ(ta, tb);
+      for (int k = 0; k < 3; k++) {
+        ASSERT_EQ(va[k], vb[k]);
+      }
+      differs = differs || ta != tc || va[0] != vc[0];
+      times.push_back(ta);
+      values.push_back(va[2]);
+    }
+    EXPECT_TRUE(differs);
+    EXPECT_GT(a.DroppedCount(), 0u);
+    EXPECT_GT(a.ReorderedCount(), 0u);
+    EXPECT_EQ(a.RowCount(), 5000u);
+
+    // Reset reproduces rows
+    a.Reset();
+    for (int i = 0; i < 5000; i++) {
+      a.Next(ta, va);
+      ASSERT_EQ(ta, times[i]);
+      ASSERT_EQ(va[2], values[i]);
+    }
+  }
+
+  void TimingTest() {
+    SignalGenerator generator(1, 100.0, 3);
+    generator.SetJitter(0.2);
+    generator.SetDropout(0.02, 4);
+    generator.SetReorder(0.05);
+    double last = -1.0;
+    uint64_t inversions = 0;
+    uint64_t gaps = 0;
+    double time;
+    float value;
+    for (int i = 0; i < 10000; i++) {
+      generator.Next(time, &value);
+      if (time < last) {
+        inversions++;
+      } else if (i > 0 && time - last > 0.019) {
+        gaps++;
+      }
+      last = time;
+    }
+    EXPECT_EQ(inversions, generator.ReorderedCount());
+    EXPECT_GT(gaps, 0u);
+    // without faults, samples are at nominal times
+    SignalGenerator nominal(1, 50.0, 3, 10.0);
+    for (int i = 0; i < 100; i++) {
+      nominal.Next(time, &value);
+      EXPECT_DOUBLE_EQ(time, 10.0 + i * 0.02);
+      EXPECT_EQ(value, 0.0);
+    }
+  }
+
+  void GaitTest() {
+    // peak of gait is at cadence or its harmonics
+    SignalGenerator generator(1, 100.0, 1);
+    generator.AddGait(0, 5.0, 2.0, 0.3, 0.02);
+    WaveletConverter conv(0.5, 2.0, 4, 2048, 4.0);
+    double time;
+    float value;
+    for (int i = 0; i < 2000; i++) {
+      generator.Next(time, &value);
+      EXPECT_GE(value, 0.0);
+      conv.AddValue(time, value);
+    }
+    std::vector<float> result;
+    conv.Convert(result);
+    // 0.5, 1.0, 2.0, 4.0 [Hz]
+    EXPECT_GT(result[2], result[0]);
+    EXPECT_GT(result[2], result[1]);
+  }
+};
+
+TEST_F(SignalGeneratorTest, SameSeedSameRows) {
+  SeedTest();
+}
+
+TEST_F(SignalGeneratorTest, TimingFaults) {
+  TimingTest();
+}
+
+TEST_F(SignalGeneratorTest, GaitFundamental) {
+  GaitTest();
+}
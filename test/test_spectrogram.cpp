@@ -0,0 +1,99 @@
+/// @file test_spectrogram.cpp
+/// @brief Test for Spectrogram
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "freq_analysis/spectrogram.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::Spectrogram;
+using freq_analysis::SpectrogramView;
+
+class SpectrogramTest : public testing::Test {
+ protected:
+  void Fill(Spectrogram& spec, size_t rows) {
+    std::vector<float> values(spec.Bands());
+    for (size_t r = 0; r < rows; r++) {
+      for (size_t i = 0; i < values.size(); i++) {
+        values[i] = r * 100.0f + i;
+      }
+      spec.Append(r * 0.1f, values);
+    }
+  }
+
+  void LayoutTest() {
+    std::vector<float> freqs;
+    for (int i = 0; i < 5; i++) {
+      freqs.push_back(0.5f * (i + 1));
+    }
+    Spectrogram row_major(freqs, freq_analysis::kRowMajor);
+    Spectrogram col_major(freqs, freq_analysis::kColumnMajor);
+    // crosses several growth steps
+    Fill(row_major, 100);
+    Fill(col_major, 100);
+    ASSERT_EQ(row_major.Rows(), 100u);
+    ASSERT_EQ(col_major.Rows(), 100u);
+    ASSERT_EQ(col_major.Bands(), 5u);
+
+    for (size_t r = 0; r < 100; r++) {
+      for (size_t i = 0; i < 5; i++) {
+        float expected = r * 100.0f + i;
+        ASSERT_EQ(row_major.At(r, i), expected);
+        ASSERT_EQ(col_major.At(r, i), expected);
+      }
+    }
+
+    std::vector<float> row;
+    col_major.Row(42).CopyTo(row);
+    ASSERT_EQ(row.size(), 5u);
+    ASSERT_EQ(row[3], 4203.0f);
+
+    SpectrogramView band = row_major.Band(2, 10, 20);
+    ASSERT_EQ(band.size(), 10u);
+    for (size_t j = 0; j < band.size(); j++) {
+      ASSERT_EQ(band[j], (10 + j) * 100.0f + 2);
+    }
+    SpectrogramView full = col_major.Band(4);
+    ASSERT_EQ(full.size(), 100u);
+    ASSERT_EQ(full[99], 9904.0f);
+  }
+
+  void RandomAccessTest() {
+    std::vector<float> freqs(3, 1.0f);
+    Spectrogram spec(freqs, freq_analysis::kColumnMajor);
+    spec.Resize(10);
+    std::vector<float> values(3);
+    for (size_t r = 10; r-- > 0;) {
+      values[0] = r;
+      values[1] = r + 0.5f;
+      values[2] = -1.0f * r;
+      spec.SetRow(r, r * 2.0f, values);
+    }
+    ASSERT_EQ(spec.Rows(), 10u);
+    ASSERT_EQ(spec.At(7, 1), 7.5f);
+    ASSERT_EQ(spec.Times()[7], 14.0f);
+
+    size_t begin, end;
+    spec.TimeRange(3.0f, 9.0f, begin, end);
+    ASSERT_EQ(begin, 2u);
+    ASSERT_EQ(end, 5u);
+
+    spec.Clear();
+    ASSERT_EQ(spec.Rows(), 0u);
+    ASSERT_EQ(spec.Band(0).size(), 0u);
+  }
+};
+
+TEST_F(SpectrogramTest, Layout) {
+  LayoutTest();
+}
+
+TEST_F(SpectrogramTest, RandomAccess) {
+  RandomAccessTest();
+}
@@ -0,0 +1,100 @@
+/// @file test_spectrum_publisher.cpp
+/// @brief Test for SpectrumPublisher
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include <math.h>
+
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/spectrum_publisher.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::Spectrum;
+using freq_analysis::SpectrumPublisher;
+using freq_analysis::SpectrumPublisherPtr;
+using freq_analysis::WaveletConverter;
+
+class SpectrumPublisherTest : public testing::Test {
+ protected:
+  void ConverterTest() {
+    WaveletConverter conv(5.0, 2.0, 5, 1024, 0.0);
+    std::vector<float> freqs;
+    conv.Frequencies(freqs);
+    SpectrumPublisherPtr publisher(new SpectrumPublisher(freqs));
+    conv.SetPublisher(publisher);
+
+    Spectrum spectrum;
+    EXPECT_FALSE(publisher->Read(spectrum));
+
+    float omega = 2.0 * M_PI * 20.0;
+    for (float t = -0.5; t < 0.5; t += 0.003) {
+      conv.AddValue(t, sin(omega * t));
+    }
+    std::vector<float> result;
+    conv.Convert(result);
+
+    ASSERT_TRUE(publisher->Read(spectrum));
+    EXPECT_EQ(spectrum.sequence, 1u);
+    ASSERT_EQ(spectrum.values.size(), result.size());
+    ASSERT_EQ(spectrum.frequencies.size(), freqs.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      EXPECT_EQ(spectrum.values[i], result[i]);
+      EXPECT_EQ(spectrum.frequencies[i], freqs[i]);
+    }
+  }
+
+  void ConsistencyTest() {
+    // writer publishes rows where every value equals the time stamp,
+    // so a torn read shows up as mismatched elements
+    std::vector<float> freqs(64, 1.0);
+    SpectrumPublisher publisher(freqs);
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+      readers.push_back(std::thread([&]() {
+            Spectrum spectrum;
+            while (!done.load()) {
+              if (!publisher.Read(spectrum)) {
+                continue;
+              }
+              for (size_t i = 0; i < spectrum.values.size(); i++) {
+                if (spectrum.values[i] != spectrum.time) {
+                  torn++;
+                  break;
+                }
+              }
+            }
+          }));
+    }
+
+    std::vector<float> values(freqs.size());
+    for (int n = 1; n <= 20000; n++) {
+      values.assign(values.size(), static_cast<float>(n));
+      publisher.Publish(static_cast<float>(n), values);
+    }
+    done = true;
+    for (size_t r = 0; r < readers.size(); r++) {
+      readers[r].join();
+    }
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(publisher.Sequence(), 20000u);
+  }
+};
+
+TEST_F(SpectrumPublisherTest, PublishFromConverter) {
+  ConverterTest();
+}
+
+TEST_F(SpectrumPublisherTest, ConsistentSnapshot) {
+  ConsistencyTest();
+}
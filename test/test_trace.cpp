@@ -0,0 +1,99 @@
+/// @file test_trace.cpp
+/// @brief Test for Tracer and TraceScope
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <thread>
+
+#include <stdio.h>
+
+#include "freq_analysis/trace.hpp"
+
+#include "gtest/gtest.h"
+
+using freq_analysis::Tracer;
+using freq_analysis::TraceScope;
+
+class TraceTest : public testing::Test {
+ protected:
+  size_t Count(const std::string& str, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = str.find(pattern); pos != std::string::npos;
+         pos = str.find(pattern, pos + 1)) {
+      count++;
+    }
+    return count;
+  }
+
+  void RecordTest() {
+    Tracer::Clear();
+    Tracer::Enable(false);
+    {
+      TraceScope trace("disabled");
+    }
+    ASSERT_EQ(Tracer::EventCount(), 0u);
+
+    Tracer::Enable(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; t++) {
+      threads.push_back(std::thread([t]() {
+            Tracer::SetThreadName("worker \"" + std::to_string(t) + "\"");
+            for (int i = 0; i < 100; i++) {
+              TraceScope trace("Filter", "band", i);
+            }
+          }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+      threads[t].join();
+    }
+    {
+      TraceScope trace("main");
+    }
+    Tracer::Enable(false);
+    ASSERT_EQ(Tracer::EventCount(), 301u);
+    ASSERT_EQ(Tracer::DroppedCount(), 0u);
+
+    std::string filename("test_trace.json");
+    ASSERT_TRUE(Tracer::Write(filename));
+    std::ifstream file(filename.c_str());
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string json = ss.str();
+    remove(filename.c_str());
+
+    EXPECT_EQ(json.compare(0, 1, "{"), 0);
+    EXPECT_EQ(Count(json, "\"ph\":\"X\""), 301u);
+    EXPECT_EQ(Count(json, "\"args\":{\"band\":99}"), 3u);
+    EXPECT_EQ(Count(json, "\"thread_name\""), 3u);
+    EXPECT_EQ(Count(json, "worker \\\"1\\\""), 1u);
+
+    Tracer::Clear();
+    ASSERT_EQ(Tracer::EventCount(), 0u);
+  }
+
+  void OverflowTest() {
+    Tracer::Clear();
+    Tracer::Enable(true);
+    for (size_t i = 0; i < Tracer::kBufferEvents + 10; i++) {
+      TraceScope trace("event");
+    }
+    Tracer::Enable(false);
+    EXPECT_EQ(Tracer::EventCount(), Tracer::kBufferEvents);
+    EXPECT_EQ(Tracer::DroppedCount(), 10u);
+    Tracer::Clear();
+  }
+};
+
+TEST_F(TraceTest, Record) {
+  RecordTest();
+}
+
+TEST_F(TraceTest, Overflow) {
+  OverflowTest();
+}
@@ -4,16 +4,20 @@
 /// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
 
 #include <iostream>
+#include <fstream>
 #include <stdint.h>
 #include <vector>
 #include <string>
 
+#include <stdio.h>
 #include <math.h>
 
 #include "freq_analysis/wavelet_converter.hpp"
 
 #include "gtest/gtest.h"
 
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
 using freq_analysis::WaveletConverter;
 
 class WaveletConverterTest : public testing::Test {
@@ -50,9 +54,198 @@ class WaveletConverterTest : public testing::Test {
       }
     }
   }
-  
+
+  void DeadlineTest() {
+    WaveletConverter conv(5.0, 2.0, 5, 1024, 0.0);
+    float omega = 2.0 * M_PI * 20.0;
+    for (float t = -0.5; t < 0.5; t += 0.003) {
+      conv.AddValue(t, sin(omega * t));
+    }
+
+    std::vector<float> full;
+    conv.Convert(full);
+
+    std::vector<float> result;
+    std::vector<bool> stale;
+    // enough budget: same as Convert
+    EXPECT_TRUE(conv.ConvertWithin(10.0, result, stale));
+    ASSERT_EQ(result.size(), full.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      EXPECT_FLOAT_EQ(result[i], full[i]);
+      EXPECT_FALSE(stale[i]);
+    }
+    EXPECT_EQ(conv.DegradedCount(), 0u);
+
+    // no budget: only highest priority filter is evaluated
+    std::vector<size_t> order;
+    order.push_back(2);
+    conv.SetPriority(order);
+    conv.ClearValue();
+    for (float t = -0.5; t < 0.5; t += 0.003) {
+      conv.AddValue(t, sin(omega * 2.0 * t));
+    }
+    EXPECT_FALSE(conv.ConvertWithin(0.0, result, stale));
+    EXPECT_EQ(conv.DegradedCount(), 1u);
+    for (size_t i = 0; i < result.size(); i++) {
+      if (i == 2) {
+        EXPECT_FALSE(stale[i]);
+        EXPECT_TRUE(result[i] < 10.0);
+      } else {
+        EXPECT_TRUE(stale[i]);
+        EXPECT_FLOAT_EQ(result[i], full[i]);
+      }
+    }
+  }
+
+  void PruningTest() {
+    const float threshold = 10.0;
+    WaveletConverter exact(5.0, 2.0, 5, 256, 0.0);
+    WaveletConverter pruned(5.0, 2.0, 5, 256, 0.0);
+    pruned.EnablePruning(threshold, 5);
+
+    // growing amplitude changes signal energy and responses of bands
+    // away from the tone ripple, so pruned bands have nonzero error.
+    // Refresh interval is out of step with the ripple, see
+    // PruningErrorEstimates.
+    float in_freq = 20.0;
+    float omega = 2.0 * M_PI * in_freq;
+    std::vector<float> freqs;
+    exact.Frequencies(freqs);
+    std::vector<float> exact_result;
+    std::vector<float> pruned_result;
+    std::vector<float> last_result;
+    std::vector<float> errors;
+    double estimate_sum = 0.0;
+    double error_sum = 0.0;
+    uint64_t pruned_bands = 0;
+    for (int n = 0; n < 1000; n++) {
+      float t = n * 0.003;
+      float value = (1.0 + n * 0.002) * sin(omega * t);
+      exact.AddValue(t, value);
+      pruned.AddValue(t, value);
+      if (n < 256) {
+        continue;
+      }
+      exact.Convert(exact_result);
+      pruned.Convert(pruned_result);
+      pruned.PruningErrorEstimates(errors);
+      ASSERT_EQ(pruned_result.size(), exact_result.size());
+      ASSERT_EQ(errors.size(), exact_result.size());
+      for (size_t i = 0; i < freqs.size(); i++) {
+        // pruned band reuses its last value
+        bool reused = !last_result.empty() &&
+            pruned_result[i] == last_result[i];
+        if (fabs(freqs[i] - in_freq) < 1e-5) {
+          // peak is always evaluated exactly
+          EXPECT_FALSE(reused);
+          EXPECT_FLOAT_EQ(pruned_result[i], exact_result[i]);
+          EXPECT_EQ(errors[i], 0.0);
+        } else if (reused) {
+          // both values are predicted below threshold
+          EXPECT_NEAR(pruned_result[i], exact_result[i], threshold);
+          EXPECT_GT(errors[i], 0.0);
+          estimate_sum += errors[i];
+          error_sum += fabs(pruned_result[i] - exact_result[i]);
+          pruned_bands++;
+        } else {
+          EXPECT_FLOAT_EQ(pruned_result[i], exact_result[i]);
+          EXPECT_EQ(errors[i], 0.0);
+        }
+      }
+      last_result = pruned_result;
+    }
+    EXPECT_GT(pruned.PrunedCount(), 0u);
+    EXPECT_EQ(pruned_bands, pruned.PrunedCount());
+    // estimates follow real error over the run
+    EXPECT_NEAR(estimate_sum, error_sum, 0.5 * error_sum);
+  }
+
+  void SharedBankTest() {
+    FilterBankPtr bank(new FilterBank(5.0, 2.0, 5));
+    WaveletConverter conv1(bank, 1024, 0.0);
+    WaveletConverter conv2(bank, 1024, 0.0);
+    WaveletConverter reference(5.0, 2.0, 5, 1024, 0.0);
+    EXPECT_EQ(conv1.Bank(), conv2.Bank());
+
+    float omega = 2.0 * M_PI * 20.0;
+    for (float t = -0.5; t < 0.5; t += 0.003) {
+      conv1.AddValue(t, sin(omega * t));
+      conv2.AddValue(t, cos(omega * t));
+      reference.AddValue(t, sin(omega * t));
+    }
+    std::vector<float> result1;
+    std::vector<float> result2;
+    std::vector<float> expected;
+    conv1.Convert(result1);
+    conv2.Convert(result2);
+    reference.Convert(expected);
+    EXPECT_EQ(result1, expected);
+    EXPECT_NE(result2, expected);
+  }
+
+  void StatsTest() {
+    FilterBankPtr bank(new FilterBank(5.0, 2.0, 3));
+    WaveletConverter conv(bank, 100, 0.0);
+    WaveletConverter other(bank, 100, 0.0);
+    for (int i = 0; i < 150; i++) {
+      conv.AddValue(i * 0.01, sin(i * 0.3));
+    }
+    other.AddValue(0.0, 1.0);
+    std::vector<float> result;
+    conv.Convert(result);
+    conv.Convert(result);
+    other.Convert(result);
+
+    freq_analysis::ConverterStats stats;
+    conv.Stats(stats);
+    EXPECT_EQ(stats.buffer_occupancy, 100u);
+    EXPECT_EQ(stats.buffer_capacity, 100u);
+    EXPECT_GT(stats.memory_bytes, 200 * sizeof(float));
+    EXPECT_GT(stats.bank_memory_bytes, 0u);
+    ASSERT_EQ(stats.band_samples_visited.size(), 3u);
+#ifdef FREQ_ANALYSIS_ENABLE_STATS
+    EXPECT_EQ(stats.samples_ingested, 150u);
+    EXPECT_EQ(stats.convert_calls, 2u);
+    EXPECT_EQ(stats.evictions, 50u);
+    // converter sharing the bank does not count here
+    EXPECT_EQ(stats.band_samples_visited[1], 200u);
+#else
+    EXPECT_EQ(stats.samples_ingested, 0u);
+    EXPECT_EQ(stats.band_samples_visited[1], 0u);
+#endif
+
+    std::string filename("test_wavelet_converter_stats.txt");
+    ASSERT_TRUE(conv.DumpStats(filename));
+    std::ifstream file(filename.c_str());
+    std::string key;
+    file >> key;
+    EXPECT_EQ(key, "samples_ingested");
+    file.close();
+    remove(filename.c_str());
+
+    conv.ResetStats();
+    conv.Stats(stats);
+    EXPECT_EQ(stats.convert_calls, 0u);
+    EXPECT_EQ(stats.band_nanoseconds[0], 0u);
+  }
 };
 
 TEST_F(WaveletConverterTest, PeakFrequency) {
   ConverterTest();
 }
+
+TEST_F(WaveletConverterTest, DeadlineBoundedConvert) {
+  DeadlineTest();
+}
+
+TEST_F(WaveletConverterTest, EnergyPruning) {
+  PruningTest();
+}
+
+TEST_F(WaveletConverterTest, SharedFilterBank) {
+  SharedBankTest();
+}
+
+TEST_F(WaveletConverterTest, Stats) {
+  StatsTest();
+}
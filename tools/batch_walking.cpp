@@ -0,0 +1,243 @@
+/// @file batch_walking.cpp
+/// @brief Process many imu data files of walking on a thread pool
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <fstream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/imu_preprocessor.hpp"
+#include "freq_analysis/result_writer.hpp"
+#include "freq_analysis/batch_layout.hpp"
+
+using freq_analysis::BatchLayout;
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ImuPreprocessor;
+using freq_analysis::DerivedChannel;
+using freq_analysis::TextResultWriter;
+using freq_analysis::WaveletConverter;
+
+namespace fs = std::filesystem;
+
+/// @brief Files given by directories, data files or list files
+class BatchProcessor {
+ public:
+  BatchProcessor(const std::string& output_dir,
+                 const std::string& manifest) :
+      output_dir_(output_dir), manifest_(manifest), time_offset_(8.0),
+      samples_(0), failed_(0) {
+    // same filters as sample_walking, shared by all workers
+    bank_ = FilterBankPtr(new FilterBank(0.25, sqrt(2.0), 10, 1.0));
+  }
+
+  void AddInput(const std::string& input) {
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+      std::vector<std::string> found;
+      for (fs::directory_iterator it(input, ec), end; it != end;
+           it.increment(ec)) {
+        if (it->path().extension() == ".dat") {
+          found.push_back(it->path().string());
+        }
+      }
+      std::sort(found.begin(), found.end());
+      file_list_.insert(file_list_.end(), found.begin(), found.end());
+    } else if (fs::path(input).extension() == ".dat") {
+      file_list_.push_back(input);
+    } else {
+      // list file with one data file per line
+      std::ifstream listfile(input.c_str());
+      std::string line;
+      while (getline(listfile, line)) {
+        if (!line.empty() && line[0] != '#') {
+          file_list_.push_back(line);
+        }
+      }
+    }
+  }
+
+  /// @brief Skip files already recorded in manifest
+  void LoadManifest() {
+    std::ifstream manifestfile(manifest_.c_str());
+    std::string line;
+    while (getline(manifestfile, line)) {
+      done_.insert(line);
+    }
+  }
+
+  /// @brief Output files mirror tree of inputs below their common root,
+  ///        planned over all inputs so resumed runs keep same paths
+  bool PlanOutputs() {
+    BatchLayout layout(output_dir_, ".result.dat");
+    if (!layout.Plan(file_list_)) {
+      return false;
+    }
+    std::vector<std::string> remaining;
+    for (size_t i = 0; i < layout.Inputs().size(); i++) {
+      if (done_.find(layout.Inputs()[i]) == done_.end()) {
+        remaining.push_back(layout.Inputs()[i]);
+        result_list_.push_back(layout.Outputs()[i]);
+      }
+    }
+    std::cout << layout.Inputs().size() - remaining.size()
+              << " files already done" << std::endl;
+    file_list_.swap(remaining);
+    return true;
+  }
+
+  bool Run(size_t threads) {
+    if (!PlanOutputs()) {
+      return false;
+    }
+    std::error_code ec;
+    fs::create_directories(output_dir_, ec);
+    manifest_file_.open(manifest_.c_str(), std::ios::app);
+    if (!manifest_file_) {
+      std::cerr << "cannot open manifest: " << manifest_ << std::endl;
+      return false;
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+      workers.push_back(std::thread([&]() {
+            size_t i;
+            while ((i = next++) < file_list_.size()) {
+              ProcessFile_(file_list_[i], result_list_[i]);
+            }
+          }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+      workers[t].join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "files: " << file_list_.size() - failed_
+              << " (" << failed_ << " failed)" << std::endl;
+    std::cout << "samples: " << samples_ << std::endl;
+    std::cout << "time: " << seconds << "[s]" << std::endl;
+    std::cout << "throughput: " << samples_ / seconds << " samples/s, "
+              << (file_list_.size() - failed_) / seconds << " files/s"
+              << std::endl;
+    return failed_ == 0;
+  }
+
+ private:
+  std::string output_dir_;
+  std::string manifest_;
+  float time_offset_;
+  FilterBankPtr bank_;
+  std::vector<std::string> file_list_;
+  std::vector<std::string> result_list_;
+  std::set<std::string> done_;
+
+  std::mutex manifest_mutex_;
+  std::ofstream manifest_file_;
+  std::atomic<uint64_t> samples_;
+  std::atomic<size_t> failed_;
+
+  void ProcessFile_(const std::string& filename,
+                    const std::string& resultname) {
+    ImuColumns data;
+    ImuDataReader reader(1);
+    if (!reader.Read(filename, data)) {
+      failed_++;
+      return;
+    }
+
+    WaveletConverter conv(bank_, 1024, time_offset_);
+    std::error_code ec;
+    fs::create_directories(fs::path(resultname).parent_path(), ec);
+    TextResultWriter writer;
+    if (!writer.Open(resultname, bank_->Frequencies())) {
+      failed_++;
+      return;
+    }
+
+    std::vector<DerivedChannel> channels(1, freq_analysis::kAccNorm);
+    ImuPreprocessor preprocessor(channels);
+    std::vector<std::vector<float> > derived;
+    preprocessor.Process(data, 0, data.size(), derived);
+
+    float start_proc = time_offset_ * 2.0;
+    std::vector<float> result;
+    for (size_t i = 0; i < data.size(); i++) {
+      conv.AddValue(data.time[i], derived[0][i]);
+      if (data.time[i] > start_proc) {
+        conv.Convert(result);
+        writer.Write(data.time[i] - time_offset_, result);
+      }
+    }
+    if (!writer.Close()) {
+      failed_++;
+      return;
+    }
+    samples_ += data.size();
+
+    // recorded only after output is complete, so interrupted files rerun
+    std::lock_guard<std::mutex> lock(manifest_mutex_);
+    manifest_file_ << filename << std::endl;
+  }
+};
+
+int main(int argc, char** argv) {
+  size_t threads = std::thread::hardware_concurrency();
+  std::string output_dir("batch_output");
+  std::string manifest;
+  int arg = 1;
+  while (argc > arg + 1 && std::string(argv[arg]).compare(0, 2, "--") == 0) {
+    std::string option(argv[arg]);
+    if (option == "--threads") {
+      threads = atoi(argv[arg + 1]);
+    } else if (option == "--out") {
+      output_dir = argv[arg + 1];
+    } else if (option == "--manifest") {
+      manifest = argv[arg + 1];
+    } else {
+      std::cerr << "unknown option: " << option << std::endl;
+      return 1;
+    }
+    arg += 2;
+  }
+  if (argc - arg < 1) {
+    std::cerr << "usage: batch_walking [--threads N] [--out DIR]"
+              << " [--manifest FILE] <directory|data file|list file>..."
+              << std::endl;
+    return 1;
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+  if (manifest.empty()) {
+    manifest = (fs::path(output_dir) / "manifest.txt").string();
+  }
+
+  BatchProcessor processor(output_dir, manifest);
+  for (; arg < argc; arg++) {
+    processor.AddInput(argv[arg]);
+  }
+  processor.LoadManifest();
+  return processor.Run(threads) ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/// @file dat2bin.cpp
+/// @brief Convert imu data file into binary columnar log
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdlib.h>
+
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/columnar_log.hpp"
+
+using freq_analysis::ImuColumns;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ColumnarLogWriter;
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: dat2bin <data file> <binary file> [block rows]"
+              << std::endl;
+    return 1;
+  }
+  uint32_t block_rows = 4096;
+  if (argc >= 4) {
+    block_rows = atoi(argv[3]);
+    if (block_rows == 0) {
+      std::cerr << "invalid block rows." << std::endl;
+      return 1;
+    }
+  }
+
+  ImuColumns data;
+  ImuDataReader reader;
+  if (!reader.Read(argv[1], data)) {
+    std::cerr << "invalid or missing data file: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> names;
+  names.push_back("time");
+  names.push_back("acc.x");
+  names.push_back("acc.y");
+  names.push_back("acc.z");
+  names.push_back("gyro.x");
+  names.push_back("gyro.y");
+  names.push_back("gyro.z");
+
+  ColumnarLogWriter writer;
+  if (!writer.Open(argv[2], names, block_rows)) {
+    return 1;
+  }
+  float row[ImuDataReader::kFields];
+  for (size_t i = 0; i < data.size(); i++) {
+    row[0] = data.time[i];
+    row[1] = data.acc_x[i];
+    row[2] = data.acc_y[i];
+    row[3] = data.acc_z[i];
+    row[4] = data.gyro_x[i];
+    row[5] = data.gyro_y[i];
+    row[6] = data.gyro_z[i];
+    writer.Write(row);
+  }
+  if (!writer.Close()) {
+    std::cerr << "cannot write file: " << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << data.size() << " rows written to " << argv[2] << std::endl;
+  return 0;
+}
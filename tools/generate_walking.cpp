@@ -0,0 +1,208 @@
+/// @file generate_walking.cpp
+/// @brief Generate synthetic imu data of walking of any length
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freq_analysis/signal_generator.hpp"
+#include "freq_analysis/imu_data_reader.hpp"
+#include "freq_analysis/columnar_log.hpp"
+
+using freq_analysis::SignalGenerator;
+using freq_analysis::ImuDataReader;
+using freq_analysis::ColumnarLogWriter;
+
+namespace {
+
+const size_t kChannels = ImuDataReader::kFields - 1;
+
+/// @brief Walking-like signal: impacts of steps on acc over gravity,
+///        swing of legs at half of cadence on gyro
+void AddWalking(SignalGenerator& generator, float cadence, float noise) {
+  generator.SetOffset(1, 9.3);
+  generator.SetOffset(2, 5.4);
+  generator.AddGait(0, 3.0, cadence, 0.25);
+  generator.AddGait(1, 6.0, cadence, 0.25);
+  generator.AddGait(2, 2.0, cadence, 0.3);
+  generator.AddTone(0, 0.8, cadence * 0.5);
+  generator.AddTone(3, 0.6, cadence * 0.5, 0.5);
+  generator.AddTone(4, 0.3, cadence * 0.5, 1.0);
+  generator.AddTone(5, 1.2, cadence * 0.5);
+  generator.AddTone(5, 0.3, cadence * 1.5);
+  for (size_t c = 0; c < kChannels; c++) {
+    generator.AddNoise(c, c < 3 ? noise : noise * 0.2);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double seconds = 600.0;
+  float rate = 100.0;
+  uint32_t seed = 1;
+  double start = 0.0;
+  float cadence = 1.8;
+  float noise = 0.1;
+  bool walking = true;
+  float jitter = 0.0;
+  float dropout = 0.0;
+  size_t dropout_length = 1;
+  float reorder = 0.0;
+  std::string datfile;
+  std::string binfile;
+  uint32_t block_rows = 4096;
+  // components added on top of walking, applied after generator is created
+  std::vector<std::vector<float> > tones;
+  std::vector<std::vector<float> > chirps;
+
+  int arg = 1;
+  while (argc > arg && std::string(argv[arg]).compare(0, 2, "--") == 0) {
+    std::string option(argv[arg]);
+    if (option == "--seconds" && argc > arg + 1) {
+      seconds = atof(argv[++arg]);
+    } else if (option == "--rate" && argc > arg + 1) {
+      rate = atof(argv[++arg]);
+    } else if (option == "--seed" && argc > arg + 1) {
+      seed = strtoul(argv[++arg], NULL, 10);
+    } else if (option == "--start" && argc > arg + 1) {
+      start = atof(argv[++arg]);
+    } else if (option == "--cadence" && argc > arg + 1) {
+      cadence = atof(argv[++arg]);
+    } else if (option == "--noise" && argc > arg + 1) {
+      noise = atof(argv[++arg]);
+    } else if (option == "--no-walking") {
+      walking = false;
+    } else if (option == "--tone" && argc > arg + 3) {
+      std::vector<float> tone;
+      for (int i = 0; i < 3; i++) {
+        tone.push_back(atof(argv[++arg]));
+      }
+      tones.push_back(tone);
+    } else if (option == "--chirp" && argc > arg + 5) {
+      std::vector<float> chirp;
+      for (int i = 0; i < 5; i++) {
+        chirp.push_back(atof(argv[++arg]));
+      }
+      chirps.push_back(chirp);
+    } else if (option == "--jitter" && argc > arg + 1) {
+      jitter = atof(argv[++arg]);
+    } else if (option == "--dropout" && argc > arg + 2) {
+      dropout = atof(argv[++arg]);
+      dropout_length = atoi(argv[++arg]);
+    } else if (option == "--reorder" && argc > arg + 1) {
+      reorder = atof(argv[++arg]);
+    } else if (option == "--dat" && argc > arg + 1) {
+      datfile = std::string(argv[++arg]);
+    } else if (option == "--bin" && argc > arg + 1) {
+      binfile = std::string(argv[++arg]);
+    } else if (option == "--block-rows" && argc > arg + 1) {
+      block_rows = atoi(argv[++arg]);
+    } else {
+      std::cerr << "unknown option: " << option << std::endl;
+      return 1;
+    }
+    arg++;
+  }
+  if (argc != arg || (datfile.empty() && binfile.empty())) {
+    std::cerr << "usage: generate_walking [--seconds S] [--rate Hz]"
+              << " [--seed N] [--start s] [--cadence Hz] [--noise S]"
+              << " [--no-walking] [--tone channel amp Hz]..."
+              << " [--chirp channel amp Hz Hz period]..."
+              << " [--jitter F] [--dropout P max_length] [--reorder P]"
+              << " [--dat file|-] [--bin file] [--block-rows N]"
+              << std::endl;
+    return 1;
+  }
+  if (seconds <= 0.0 || rate <= 0.0 || block_rows == 0) {
+    std::cerr << "seconds, rate and block rows must be positive"
+              << std::endl;
+    return 1;
+  }
+  if (!binfile.empty() && reorder > 0.0) {
+    // time index of columnar log needs non-decreasing time
+    std::cerr << "--reorder cannot be written to --bin" << std::endl;
+    return 1;
+  }
+
+  SignalGenerator generator(kChannels, rate, seed, start);
+  if (walking) {
+    AddWalking(generator, cadence, noise);
+  } else if (noise > 0.0) {
+    for (size_t c = 0; c < kChannels; c++) {
+      generator.AddNoise(c, noise);
+    }
+  }
+  for (size_t i = 0; i < tones.size(); i++) {
+    generator.AddTone(tones[i][0], tones[i][1], tones[i][2]);
+  }
+  for (size_t i = 0; i < chirps.size(); i++) {
+    generator.AddChirp(chirps[i][0], chirps[i][1], chirps[i][2],
+                       chirps[i][3], chirps[i][4]);
+  }
+  generator.SetJitter(jitter);
+  generator.SetDropout(dropout, dropout_length);
+  generator.SetReorder(reorder);
+
+  FILE* dat = NULL;
+  if (datfile == "-") {
+    dat = stdout;
+  } else if (!datfile.empty()) {
+    dat = fopen(datfile.c_str(), "w");
+    if (!dat) {
+      std::cerr << "cannot open file: " << datfile << std::endl;
+      return 1;
+    }
+  }
+  if (dat) {
+    fprintf(dat, "# time acc.x acc.y acc.z gyro.x gyro.y gyro.z\n");
+  }
+  ColumnarLogWriter writer;
+  if (!binfile.empty()) {
+    std::vector<std::string> names;
+    names.push_back("time");
+    names.push_back("acc.x");
+    names.push_back("acc.y");
+    names.push_back("acc.z");
+    names.push_back("gyro.x");
+    names.push_back("gyro.y");
+    names.push_back("gyro.z");
+    if (!writer.Open(binfile, names, block_rows)) {
+      return 1;
+    }
+  }
+
+  double end = start + seconds;
+  double time;
+  float values[kChannels];
+  uint64_t rows = 0;
+  while (generator.Next(time, values) && time < end) {
+    if (dat) {
+      fprintf(dat, "%f %f %f %f %f %f %f\n", time, values[0], values[1],
+              values[2], values[3], values[4], values[5]);
+    }
+    if (!binfile.empty()) {
+      writer.Write(time, values);
+    }
+    rows++;
+  }
+
+  bool ok = true;
+  if (dat && dat != stdout) {
+    ok = !ferror(dat) && ok;
+    fclose(dat);
+  }
+  if (!binfile.empty()) {
+    ok = writer.Close() && ok;
+  }
+  std::cerr << rows << " rows, "
+            << generator.DroppedCount() << " dropped, "
+            << generator.ReorderedCount() << " reordered" << std::endl;
+  return ok ? 0 : 1;
+}
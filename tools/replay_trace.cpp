@@ -0,0 +1,301 @@
+/// @file replay_trace.cpp
+/// @brief Replay calls recorded by CallRecorder at full speed,
+///        reporting timing and difference from recorded results
+/// @author Hiroaki Yaguchi
+/// @author Copyright (c) 2014 Hiroaki Yaguchi, JSK, The University of Tokyo
+
+#include <iostream>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "freq_analysis/filter_bank.hpp"
+#include "freq_analysis/wavelet_converter.hpp"
+#include "freq_analysis/call_recorder.hpp"
+
+using freq_analysis::CallRecord;
+using freq_analysis::CallTrace;
+using freq_analysis::CallTraceConfig;
+using freq_analysis::FilterBank;
+using freq_analysis::FilterBankPtr;
+using freq_analysis::WaveletConverter;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  CallTraceConfig config;
+  // -1: recorded pruning calls, 0: never, 1: always
+  int pruning;
+  float prune_threshold;
+  size_t refresh_interval;
+  size_t repeat;
+  float tolerance;
+};
+
+struct Timing {
+  double total;    ///< [s]
+  double convert;  ///< [s], Convert and ConvertWithin
+};
+
+struct Diff {
+  size_t compared;
+  size_t identical;
+  float max_abs;
+  float max_rel;
+};
+
+/// @brief Replay all records on new converter
+/// @param diff Difference from recorded results, NULL to skip comparison
+void Replay(const CallTrace& trace, const Options& options,
+            Timing& timing, Diff* diff) {
+  const CallTraceConfig& config = options.config;
+  FilterBankPtr bank(new FilterBank(config.start, config.step,
+                                    config.band_count, config.sigma,
+                                    config.table_resolution));
+  WaveletConverter conv(bank, config.max_buf_length, config.center_t);
+  if (options.pruning > 0) {
+    conv.EnablePruning(options.prune_threshold, options.refresh_interval);
+  }
+  std::vector<float> result;
+  std::vector<bool> stale;
+  std::vector<size_t> order;
+  timing.convert = 0.0;
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < trace.size(); i++) {
+    const CallRecord& record = trace[i];
+    bool converted = false;
+    switch (record.type) {
+      case freq_analysis::kCallAddValue:
+        conv.AddValue(record.time, record.value);
+        break;
+      case freq_analysis::kCallClearValue:
+        conv.ClearValue();
+        break;
+      case freq_analysis::kCallConvert: {
+        Clock::time_point begin = Clock::now();
+        conv.Convert(result);
+        timing.convert +=
+            std::chrono::duration<double>(Clock::now() - begin).count();
+        converted = true;
+        break;
+      }
+      case freq_analysis::kCallConvertWithin: {
+        Clock::time_point begin = Clock::now();
+        conv.ConvertWithin(record.budget, result, stale);
+        timing.convert +=
+            std::chrono::duration<double>(Clock::now() - begin).count();
+        converted = true;
+        break;
+      }
+      case freq_analysis::kCallEnablePruning:
+        if (options.pruning < 0) {
+          conv.EnablePruning(record.value, record.count);
+        }
+        break;
+      case freq_analysis::kCallDisablePruning:
+        if (options.pruning < 0) {
+          conv.DisablePruning();
+        }
+        break;
+      case freq_analysis::kCallSetPriority:
+        order.assign(trace.Indices(record),
+                     trace.Indices(record) + record.count);
+        conv.SetPriority(order);
+        break;
+    }
+    if (converted && diff) {
+      const float* recorded = trace.Results(record);
+      float peak = 0.0;
+      float max_abs = 0.0;
+      for (size_t b = 0; b < result.size(); b++) {
+        peak = std::max(peak, fabsf(recorded[b]));
+        max_abs = std::max(max_abs, fabsf(result[b] - recorded[b]));
+      }
+      diff->compared++;
+      if (max_abs == 0.0) {
+        diff->identical++;
+      }
+      diff->max_abs = std::max(diff->max_abs, max_abs);
+      if (peak > 0.0) {
+        diff->max_rel = std::max(diff->max_rel, max_abs / peak);
+      }
+    }
+  }
+  timing.total = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void PrintConfig(const CallTraceConfig& config) {
+  std::cout << "bands " << config.band_count
+            << ", start " << config.start << " [Hz]"
+            << ", step " << config.step
+            << ", sigma " << config.sigma
+            << ", table resolution " << config.table_resolution
+            << ", buffer " << config.max_buf_length
+            << ", center " << config.center_t << " [s]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.pruning = -1;
+  options.prune_threshold = 0.0;
+  options.refresh_interval = 0;
+  options.repeat = 3;
+  options.tolerance = -1.0;
+  // overrides of recorded configuration, negative if not given
+  float start = -1.0;
+  float step = -1.0;
+  float sigma = -1.0;
+  float resolution = -1.0;
+  float center = -1.0;
+  int bands = -1;
+  int buffer = -1;
+
+  int arg = 1;
+  while (argc > arg && std::string(argv[arg]).compare(0, 2, "--") == 0) {
+    std::string option(argv[arg]);
+    if (option == "--bands" && argc > arg + 1) {
+      bands = atoi(argv[++arg]);
+    } else if (option == "--start" && argc > arg + 1) {
+      start = atof(argv[++arg]);
+    } else if (option == "--step" && argc > arg + 1) {
+      step = atof(argv[++arg]);
+    } else if (option == "--sigma" && argc > arg + 1) {
+      sigma = atof(argv[++arg]);
+    } else if (option == "--table-resolution" && argc > arg + 1) {
+      resolution = atof(argv[++arg]);
+    } else if (option == "--buffer" && argc > arg + 1) {
+      buffer = atoi(argv[++arg]);
+    } else if (option == "--center" && argc > arg + 1) {
+      center = atof(argv[++arg]);
+    } else if (option == "--pruning" && argc > arg + 2) {
+      options.pruning = 1;
+      options.prune_threshold = atof(argv[++arg]);
+      options.refresh_interval = atoi(argv[++arg]);
+    } else if (option == "--no-pruning") {
+      options.pruning = 0;
+    } else if (option == "--repeat" && argc > arg + 1) {
+      options.repeat = atoi(argv[++arg]);
+    } else if (option == "--tolerance" && argc > arg + 1) {
+      options.tolerance = atof(argv[++arg]);
+    } else {
+      std::cerr << "unknown option: " << option << std::endl;
+      return 1;
+    }
+    arg++;
+  }
+  if (argc - arg != 1 || options.repeat == 0) {
+    std::cerr << "usage: replay_trace [--bands N] [--start Hz] [--step R]"
+              << " [--sigma S] [--table-resolution N] [--buffer N]"
+              << " [--center s] [--pruning threshold interval]"
+              << " [--no-pruning] [--repeat N] [--tolerance X]"
+              << " <trace file>" << std::endl;
+    return 1;
+  }
+
+  CallTrace trace;
+  if (!trace.Read(argv[arg])) {
+    return 1;
+  }
+  options.config = trace.Config();
+  CallTraceConfig& config = options.config;
+  if (bands >= 0) {
+    config.band_count = bands;
+  }
+  if (start > 0.0) {
+    config.start = start;
+  }
+  if (step > 0.0) {
+    config.step = step;
+  }
+  if (sigma > 0.0) {
+    config.sigma = sigma;
+  }
+  if (resolution > 0.0) {
+    config.table_resolution = resolution;
+  }
+  if (buffer > 0) {
+    config.max_buf_length = buffer;
+  }
+  if (center >= 0.0) {
+    config.center_t = center;
+  }
+  if (config.band_count == 0 || config.max_buf_length == 0) {
+    std::cerr << "bands and buffer must be positive" << std::endl;
+    return 1;
+  }
+
+  size_t add_count = 0;
+  size_t convert_count = 0;
+  float first_time = 0.0;
+  float last_time = 0.0;
+  for (size_t i = 0; i < trace.size(); i++) {
+    const CallRecord& record = trace[i];
+    if (record.type == freq_analysis::kCallAddValue) {
+      if (add_count == 0) {
+        first_time = record.time;
+      }
+      last_time = record.time;
+      add_count++;
+    } else if (record.type == freq_analysis::kCallConvert ||
+               record.type == freq_analysis::kCallConvertWithin) {
+      convert_count++;
+    }
+  }
+  double span = last_time - first_time;
+  std::cout << "trace: " << argv[arg] << ", " << trace.size() << " calls, "
+            << add_count << " AddValue, " << convert_count << " Convert, "
+            << span << " [s]" << std::endl;
+  std::cout << "recorded: ";
+  PrintConfig(trace.Config());
+  std::cout << "replayed: ";
+  PrintConfig(config);
+
+  bool compare = trace.HasResults() &&
+      config.band_count == trace.Config().band_count;
+  Diff diff = {0, 0, 0.0, 0.0};
+  Timing best = {0.0, 0.0};
+  for (size_t r = 0; r < options.repeat; r++) {
+    Timing timing;
+    Replay(trace, options, timing, r == 0 && compare ? &diff : NULL);
+    if (r == 0 || timing.total < best.total) {
+      best = timing;
+    }
+  }
+
+  std::cout << "timing (best of " << options.repeat << "): "
+            << best.total << " [s], AddValue "
+            << (add_count > 0 ?
+                (best.total - best.convert) / add_count * 1e9 : 0.0)
+            << " [ns], Convert "
+            << (convert_count > 0 ? best.convert / convert_count * 1e6 : 0.0)
+            << " [us], "
+            << (best.total > 0.0 ? span / best.total : 0.0)
+            << "x realtime" << std::endl;
+
+  if (!trace.HasResults()) {
+    std::cout << "diff: results not recorded" << std::endl;
+  } else if (!compare) {
+    std::cout << "diff: " << config.band_count << " bands replayed, "
+              << trace.Config().band_count << " recorded" << std::endl;
+  } else {
+    std::cout << "diff: " << diff.compared << " results, "
+              << diff.identical << " identical, max abs " << diff.max_abs
+              << ", max rel " << diff.max_rel << std::endl;
+    if (options.tolerance >= 0.0 && diff.max_abs > options.tolerance) {
+      std::cerr << "difference exceeds tolerance " << options.tolerance
+                << std::endl;
+      return 2;
+    }
+  }
+  return 0;
+}